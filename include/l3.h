@@ -12,6 +12,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <inttypes.h>
 
 #ifdef L3_LOC_ENABLED
 #include "loc.h"
@@ -27,6 +28,19 @@
  */
 #define L3_MAX_SLOTS (16384)
 
+/**
+ * Size of the separate, smaller, ring-buffer to track high-severity log
+ * entries, so that they survive floods of debug log-entries. Must be a
+ * power-of-2.
+ */
+#define L3_IMPORTANT_SLOTS (1024)
+
+/**
+ * Max # of named channels, including the "important" ring, that can be
+ * opened by l3_channel_open().
+ */
+#define L3_MAX_CHANNELS (16)
+
 /**
  * Error codes returned by API / interfaces.
  */
@@ -40,6 +54,8 @@
  * \brief Initialise the logging library.
  *
  * \param path [opt] A filename to back the map where the log will be stored.
+ *             If NULL, the log is stored in an anonymous, in-memory, map.
+ *             See l3_init_crash_dump().
  *
  * \return 0 on success, or -1 on failure with \c errno set to something appropriate.
  */
@@ -72,6 +88,45 @@ const char *l3_logtype_name(l3_log_t logtype);
 }
 #endif
 
+/**
+ * \brief Self-describing log-files: Format strings of call-sites.
+ *
+ * The caller-macros pass 'msg' through L3_FMT(), which emits the address of
+ * the string literal into the 'l3_log_fmts' section, at compile-time, at no
+ * cost to logging. l3_init() copies the format strings, with their address,
+ * into the log-file, so that l3_dump.py can decode log-entries without the
+ * program binary. The address is emitted by an assembler directive, rather
+ * than by a static variable, as C++ does not allow variables of inline
+ * functions to share a section with other variables. Not supported on
+ * Mac/OSX.
+ */
+#if __APPLE__
+
+#define L3_FMT(msg) (msg)
+
+#else   // __APPLE__
+
+#define L3_FMT(msg)                                                         \
+        ({                                                                  \
+            __asm__(".pushsection l3_log_fmts, \"aw\"\n\t"                  \
+                    ".quad %c0\n\t"                                         \
+                    ".popsection" : : "i" (msg));                           \
+            (msg);                                                          \
+        })
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const char *const __start_l3_log_fmts[] __attribute__((weak));
+extern const char *const __stop_l3_log_fmts[] __attribute__((weak));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __APPLE__
+
 /**
  * \brief Caller-macro to invoke L3 logging.
  *
@@ -84,9 +139,9 @@ const char *l3_logtype_name(l3_log_t logtype);
 
   #ifdef L3_LOC_ENABLED
 
-    #define l3_log(msg, arg1, arg2)                                     \
+    #define l3__log(msg, arg1, arg2)                                     \
             if (1) {                                                    \
-                l3_log_mmap((msg),                                      \
+                l3_log_mmap(L3_FMT(msg),                                \
                             (uint64_t) (arg1), (uint64_t) (arg2),       \
                             __LOC__);                                   \
             } else if (0) {                                             \
@@ -97,17 +152,17 @@ const char *l3_logtype_name(l3_log_t logtype);
 
     #if defined(L3_LOGT_FPRINTF)
 
-    #  define l3_log(msg, arg1, arg2) l3_log_fprintf((msg), arg1, arg2)
+    #  define l3__log(msg, arg1, arg2) l3_log_fprintf((msg), arg1, arg2)
 
     #elif defined(L3_LOGT_WRITE)
 
-    #  define l3_log(msg, arg1, arg2) l3_log_write((msg), arg1, arg2)
+    #  define l3__log(msg, arg1, arg2) l3_log_write((msg), arg1, arg2)
 
     #else
 
-    #  define l3_log(msg, arg1, arg2)                                   \
+    #  define l3__log(msg, arg1, arg2)                                   \
             if (1) {                                                    \
-                l3_log_mmap((msg),                                      \
+                l3_log_mmap(L3_FMT(msg),                                \
                             (uint64_t) (arg1), (uint64_t) (arg2),       \
                             L3_ARG_UNUSED);                             \
             } else if (0) {                                             \
@@ -122,8 +177,8 @@ const char *l3_logtype_name(l3_log_t logtype);
 
   #ifdef L3_LOC_ENABLED
 
-    #define l3_log(msg, arg1, arg2)                                     \
-            l3_log_mmap((msg),                                          \
+    #define l3__log(msg, arg1, arg2)                                     \
+            l3_log_mmap(L3_FMT(msg),                                    \
                         (uint64_t) (arg1), (uint64_t) (arg2),           \
                         __LOC__)
 
@@ -131,15 +186,15 @@ const char *l3_logtype_name(l3_log_t logtype);
 
     #if defined(L3_LOGT_FPRINTF)
 
-    #define l3_log(msg, arg1, arg2) l3_log_fprintf((msg), arg1, arg2)
+    #define l3__log(msg, arg1, arg2) l3_log_fprintf((msg), arg1, arg2)
 
     #elif defined(L3_LOGT_WRITE)
 
-    #define l3_log(msg, arg1, arg2) l3_log_write((msg), arg1, arg2)
+    #define l3__log(msg, arg1, arg2) l3_log_write((msg), arg1, arg2)
 
     #else
-    #define l3_log(msg, arg1, arg2)                                     \
-            l3_log_mmap((msg),                                          \
+    #define l3__log(msg, arg1, arg2)                                     \
+            l3_log_mmap(L3_FMT(msg),                                    \
                         (uint64_t) (arg1), (uint64_t) (arg2),           \
                         L3_ARG_UNUSED)
 
@@ -149,6 +204,115 @@ const char *l3_logtype_name(l3_log_t logtype);
 
 #endif  // defined(DEBUG)
 
+/**
+ * \brief USDT probes: Static probe points at L3 call-sites.
+ *
+ * When compiled with -DL3_USDT_ENABLED, each l3_log() and l3_log_fast()
+ * call-site also emits a SystemTap SDT probe, l3:log and l3:log_fast, with
+ * the msg, arg1 and arg2 as its 3 operands. Unattached, a probe is a NOP
+ * and a note in the '.note.stapsdt' section, so the ring-buffer is logged
+ * as without it; `perf probe`, `bpftrace` or `stap` attach to the probes to
+ * aggregate the arguments of hot call-sites, out-of-band, e.g.:
+ *
+ *   bpftrace -e 'usdt:./program:l3:log { @[str(arg0)] = count(); }'
+ *
+ * The arguments are evaluated once, before the probe. Uses <sys/sdt.h> if
+ * found, else emits the same note itself, on x86-64 and AArch64. Not
+ * supported on Mac/OSX.
+ */
+#if defined(L3_USDT_ENABLED) && !__APPLE__
+
+#if defined(__has_include)
+#  if __has_include(<sys/sdt.h>)
+#    define L3_HAVE_SYS_SDT_H 1
+#  endif
+#endif  // __has_include
+
+#if defined(L3_HAVE_SYS_SDT_H)
+
+#include <sys/sdt.h>
+
+#define L3_PROBE(name, msg, arg1, arg2) STAP_PROBE3(l3, name, msg, arg1, arg2)
+
+#elif defined(__x86_64__) || defined(__aarch64__)
+
+// Layout of the note of a probe, as emitted by <sys/sdt.h>: The address of
+// its NOP, of the .stapsdt.base section, of its semaphore, which L3 does not
+// use, followed by the provider's, the probe's and the operands' names.
+#define L3_PROBE(name, msg, arg1, arg2)                                     \
+        __asm__ __volatile__(                                               \
+            "990: nop\n\t"                                                  \
+            ".pushsection .note.stapsdt, \"?\", \"note\"\n\t"               \
+            ".balign 4\n\t"                                                 \
+            ".4byte 992f-991f, 994f-993f, 3\n\t"                            \
+            "991: .asciz \"stapsdt\"\n\t"                                   \
+            "992: .balign 4\n\t"                                            \
+            "993: .8byte 990b\n\t"                                          \
+            ".8byte _.stapsdt.base\n\t"                                     \
+            ".8byte 0\n\t"                                                  \
+            ".asciz \"l3\"\n\t"                                             \
+            ".asciz \"" #name "\"\n\t"                                      \
+            ".asciz \"8@%0 8@%1 8@%2\"\n\t"                                 \
+            "994: .balign 4\n\t"                                            \
+            ".popsection\n\t"                                               \
+            ".ifndef _.stapsdt.base\n\t"                                    \
+            ".pushsection .stapsdt.base, \"aG\", \"progbits\", "            \
+                ".stapsdt.base, comdat\n\t"                                 \
+            ".weak _.stapsdt.base\n\t"                                      \
+            ".hidden _.stapsdt.base\n\t"                                    \
+            "_.stapsdt.base: .space 1\n\t"                                  \
+            ".size _.stapsdt.base, 1\n\t"                                   \
+            ".popsection\n\t"                                               \
+            ".endif"                                                        \
+            : : "nor" ((uint64_t) (uintptr_t) (msg)),                       \
+                "nor" ((uint64_t) (arg1)), "nor" ((uint64_t) (arg2)))
+
+#else   // L3_HAVE_SYS_SDT_H, __x86_64__ || __aarch64__
+
+#define L3_PROBE(name, msg, arg1, arg2) do { } while (0)
+
+#endif  // L3_HAVE_SYS_SDT_H, __x86_64__ || __aarch64__
+
+// Type of an argument, as promoted, e.g. of an enum to an int, or as read
+// from a std::atomic<>, to evaluate it once.
+#ifdef __cplusplus
+#define L3_ARG_TYPEOF(arg) __decltype(+(arg))
+#else
+#define L3_ARG_TYPEOF(arg) __typeof__((arg) + 0)
+#endif  // __cplusplus
+
+#define L3_PROBED(name, logger, msg, arg1, arg2)                            \
+        do {                                                                \
+            const L3_ARG_TYPEOF(arg1) l3_arg1_ = (arg1);                    \
+            const L3_ARG_TYPEOF(arg2) l3_arg2_ = (arg2);                    \
+            L3_PROBE(name, (msg), l3_arg1_, l3_arg2_);                      \
+            logger(msg, l3_arg1_, l3_arg2_);                                \
+        } while (0)
+
+#else   // L3_USDT_ENABLED && !__APPLE__
+
+#define L3_PROBED(name, logger, msg, arg1, arg2) logger(msg, arg1, arg2)
+
+#endif  // L3_USDT_ENABLED && !__APPLE__
+
+/**
+ * Under L3_SITE_COUNTERS, l3_log() also counts the hits of its call-site.
+ * See l3_stats().
+ */
+#if defined(L3_SITE_COUNTERS) && !__APPLE__
+
+#define l3_log(msg, arg1, arg2)                                             \
+        do {                                                                \
+            L3_SITE_HIT(msg);                                               \
+            L3_PROBED(log, l3__log, msg, arg1, arg2);                       \
+        } while (0)
+
+#else   // L3_SITE_COUNTERS && !__APPLE__
+
+#define l3_log(msg, arg1, arg2) L3_PROBED(log, l3__log, msg, arg1, arg2)
+
+#endif  // L3_SITE_COUNTERS && !__APPLE__
+
 /**
  * \brief Log a literal string and two arguments.
  *
@@ -201,20 +365,20 @@ void l3_log_write(const char *msgfmt, const uint64_t arg1, const uint64_t arg2);
 
   #ifdef L3_LOC_ENABLED
 
-    #define l3_log_fast(msg, arg1, arg2)                                    \
+    #define l3__log_fast_(msg, arg1, arg2)                                  \
             if (1) {                                                        \
-                l3__log_fast(__LOC__,                                       \
-                             (msg), (uint64_t) (arg1), (uint64_t) (arg2));  \
+                l3__log_fast(__LOC__, L3_FMT(msg),                          \
+                             (uint64_t) (arg1), (uint64_t) (arg2));         \
             } else if (0) {                                                 \
                 printf((msg), (arg1), (arg2));                              \
             } else
 
   #else   // L3_LOC_ENABLED
 
-    #define l3_log_fast(msg, arg1, arg2)                                    \
+    #define l3__log_fast_(msg, arg1, arg2)                                  \
             if (1) {                                                        \
-                l3__log_fast(L3_ARG_UNUSED,                                 \
-                             (msg), (uint64_t) (arg1), (uint64_t) (arg2));  \
+                l3__log_fast(L3_ARG_UNUSED, L3_FMT(msg),                    \
+                             (uint64_t) (arg1), (uint64_t) (arg2));         \
             } else if (0) {                                                 \
                 printf((msg), (arg1), (arg2));                              \
             } else
@@ -224,17 +388,19 @@ void l3_log_write(const char *msgfmt, const uint64_t arg1, const uint64_t arg2);
 #else   // DEBUG
 
   #ifdef L3_LOC_ENABLED
-    #define l3_log_fast(msg, arg1, arg2)                            \
-            l3__log_fast(__LOC__, (msg),                            \
+    #define l3__log_fast_(msg, arg1, arg2)                          \
+            l3__log_fast(__LOC__, L3_FMT(msg),                      \
                          (uint64_t) (arg1), (uint64_t) (arg2))
   #else   // L3_LOC_ENABLED
-    #define l3_log_fast(msg, arg1, arg2)                            \
-            l3__log_fast(L3_ARG_UNUSED, (msg),                      \
+    #define l3__log_fast_(msg, arg1, arg2)                          \
+            l3__log_fast(L3_ARG_UNUSED, L3_FMT(msg),                \
                          (uint64_t) (arg1), (uint64_t) (arg2))
   #endif  // L3_LOC_ENABLED
 
 #endif  // DEBUG
 
+#define l3_log_fast(msg, arg1, arg2)                                        \
+        L3_PROBED(log_fast, l3__log_fast_, msg, arg1, arg2)
 
 #endif  // __APPLE__
 
@@ -254,3 +420,976 @@ void l3__log_fast(const loc_t loc, const char *msg,
 void l3__log_fast(const uint32_t loc, const char *msg,
                   const uint64_t arg1, const uint64_t arg2);
 #endif  // L3_LOC_ENABLED
+
+/**
+ * \brief Severity-levels of log-entries.
+ *
+ * L3 logs all entries to the default ring-buffer of L3_MAX_SLOTS entries,
+ * where a flood of debug entries can quickly overwrite the one error entry
+ * that explains an incident. Entries of level >= L3_IMPORTANT_LEVEL are,
+ * instead, logged to a separate, smaller, ring named "important", with its
+ * own index. l3_dump.py merges entries from both rings chronologically.
+ */
+typedef enum {
+      L3_LVL_DEBUG      = 0
+    , L3_LVL_INFO
+    , L3_LVL_WARN
+    , L3_LVL_ERROR
+    , L3_LVL_FATAL
+} l3_level_t;
+
+#ifndef L3_IMPORTANT_LEVEL
+#define L3_IMPORTANT_LEVEL  L3_LVL_WARN
+#endif  // L3_IMPORTANT_LEVEL
+
+#ifdef L3_LOC_ENABLED
+#define L3_LOC_ARG  __LOC__
+#else
+#define L3_LOC_ARG  L3_ARG_UNUSED
+#endif  // L3_LOC_ENABLED
+
+/**
+ * \brief Caller-macro to log to the ring of important entries.
+ */
+#if defined(L3_LOGT_FPRINTF) || defined(L3_LOGT_WRITE)
+
+#define l3_log_important(msg, arg1, arg2) l3_log(msg, arg1, arg2)
+
+#elif defined(DEBUG)
+
+#define l3_log_important(msg, arg1, arg2)                                   \
+        if (1) {                                                            \
+            l3_log_important_mmap(L3_FMT(msg),                              \
+                                  (uint64_t) (arg1), (uint64_t) (arg2),     \
+                                  L3_LOC_ARG);                              \
+        } else if (0) {                                                     \
+            printf((msg), (arg1), (arg2));                                  \
+        } else
+
+#else   // DEBUG
+
+#define l3_log_important(msg, arg1, arg2)                                   \
+        l3_log_important_mmap(L3_FMT(msg),                                  \
+                              (uint64_t) (arg1), (uint64_t) (arg2),         \
+                              L3_LOC_ARG)
+
+#endif  // L3_LOGT_FPRINTF || L3_LOGT_WRITE, DEBUG
+
+/**
+ * \brief Caller-macro to log with a severity-level, selecting the ring.
+ *
+ * 'level' is expected to be a compile-time constant, so the selection of
+ * the ring costs nothing at run-time.
+ */
+#define l3_log_lvl(level, msg, arg1, arg2)                                  \
+        do {                                                                \
+            if ((level) >= L3_IMPORTANT_LEVEL) {                            \
+                l3_log_important(msg, arg1, arg2);                          \
+            } else {                                                        \
+                l3_log(msg, arg1, arg2);                                    \
+            }                                                               \
+        } while (0)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef L3_LOC_ENABLED
+void l3_log_important_mmap(const char *msg, const uint64_t arg1,
+                           const uint64_t arg2, const loc_t loc);
+#else
+void l3_log_important_mmap(const char *msg, const uint64_t arg1,
+                           const uint64_t arg2, const uint32_t loc);
+#endif  // L3_LOC_ENABLED
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * \brief Caller-macro to log a short, dynamic, string.
+ *
+ *  l3_log_str("Opened file '%s'", path, strlen(path));
+ *
+ * 'msg' is a literal format string, with one "%s". Up to L3_LOG_STR_MAX bytes
+ * of the 'len' bytes of 'str', which need not be a literal, are copied into
+ * the entry and into as many continuation entries following it in the default
+ * ring as needed, all reserved at once. So the string costs a memcpy(),
+ * rather than a printf(). The entry's arg1 is the # of bytes copied, and its
+ * arg2, the first 8 of them; each continuation entry carries 28 more. The
+ * call-site is described as logging a L3_ARG_STR, so that l3_dump.py prints
+ * the string copied. Only supported by the L3_LOG_MMAP logging-type.
+ */
+#define L3_LOG_STR_MAX      56
+
+#if __APPLE__
+
+#define L3_FMT_ARG(msg, type)   (msg)
+
+#else   // __APPLE__
+
+// As L3_FMT(), and a L3_ARG_TYPES{} descriptor of the argument of 'type'.
+#define L3_FMT_ARG(msg, type)                                               \
+        ({                                                                  \
+            __asm__(".pushsection l3_log_fmts, \"aw\"\n\t"                  \
+                    ".quad %c0\n\t"                                         \
+                    ".popsection\n\t"                                       \
+                    ".pushsection l3_arg_types, \"aw\"\n\t"                 \
+                    ".balign %c2\n\t"                                       \
+                    ".quad %c0\n\t"                                         \
+                    ".byte %c1, 0, 0, 0, 0, 0, 0, 0\n\t"                     \
+                    ".popsection"                                           \
+                    : : "i" (msg), "i" (type),                              \
+                        "i" (L3_ARG_TYPES_ALIGN));                          \
+            (msg);                                                          \
+        })
+
+#endif  // __APPLE__
+
+#if defined(L3_LOGT_FPRINTF) || defined(L3_LOGT_WRITE)
+
+#define l3_log_str(msg, str, len) l3_log(msg, (uintptr_t) (str), 0)
+
+#elif defined(DEBUG)
+
+#define l3_log_str(msg, str, len)                                           \
+        if (1) {                                                            \
+            l3_log_str_mmap(L3_FMT_ARG(msg, L3_ARG_STR), (str), (len), L3_LOC_ARG);     \
+        } else if (0) {                                                     \
+            printf((msg), (const char *) (str));                            \
+        } else
+
+#else   // DEBUG
+
+#define l3_log_str(msg, str, len)                                           \
+        l3_log_str_mmap(L3_FMT_ARG(msg, L3_ARG_STR), (str), (len), L3_LOC_ARG)
+
+#endif  // L3_LOGT_FPRINTF || L3_LOGT_WRITE, DEBUG
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef L3_LOC_ENABLED
+void l3_log_str_mmap(const char *msg, const char *str, size_t len,
+                     const loc_t loc);
+#else
+void l3_log_str_mmap(const char *msg, const char *str, size_t len,
+                     const uint32_t loc);
+#endif  // L3_LOC_ENABLED
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * \brief Caller-macro to log a snapshot of a small binary buffer.
+ *
+ *  l3_log_bytes("Request: %s", "requestMsg", &req, sizeof(req));
+ *
+ * As l3_log_str(), for up to L3_LOG_BYTES_MAX bytes of a buffer, e.g. of a
+ * message, which are all copied into continuation entries. 'tag', a literal
+ * string, names the type of the buffer; it is logged as the entry's arg2.
+ * The call-site is described as logging a L3_ARG_BYTES, so that l3_dump.py
+ * decodes the bytes copied by the decoder registered for 'tag', else prints
+ * their hexdump, by the "%s" of 'msg'.
+ */
+#define L3_LOG_BYTES_MAX    128
+
+#if defined(L3_LOGT_FPRINTF) || defined(L3_LOGT_WRITE)
+
+#define l3_log_bytes(msg, tag, buf, len) l3_log(msg, (uintptr_t) (tag), 0)
+
+#elif defined(DEBUG)
+
+#define l3_log_bytes(msg, tag, buf, len)                                    \
+        if (1) {                                                            \
+            l3_log_bytes_mmap(L3_FMT_ARG(msg, L3_ARG_BYTES), L3_FMT(tag),   \
+                              (buf), (len), L3_LOC_ARG);                    \
+        } else if (0) {                                                     \
+            printf((msg), (tag));                                           \
+        } else
+
+#else   // DEBUG
+
+#define l3_log_bytes(msg, tag, buf, len)                                    \
+        l3_log_bytes_mmap(L3_FMT_ARG(msg, L3_ARG_BYTES), L3_FMT(tag),       \
+                          (buf), (len), L3_LOC_ARG)
+
+#endif  // L3_LOGT_FPRINTF || L3_LOGT_WRITE, DEBUG
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef L3_LOC_ENABLED
+void l3_log_bytes_mmap(const char *msg, const char *tag, const void *buf,
+                       size_t len, const loc_t loc);
+#else
+void l3_log_bytes_mmap(const char *msg, const char *tag, const void *buf,
+                       size_t len, const uint32_t loc);
+#endif  // L3_LOC_ENABLED
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * \brief Named channels: Independent rings per subsystem.
+ *
+ * Subsystems, e.g. networking, storage and the scheduler, can each open a
+ * channel, which is a separately sized ring, with its own idx, in the
+ * mmap()'ed log-file. This isolates their contention on the idx, and their
+ * retention of log-entries, from each other and from the default ring.
+ *
+ *  l3_channel_t net = l3_channel_open("net", 4096);
+ *  l3_log_ch(net, "Dropped packet, len=%d, port=%d", len, port);
+ *
+ * 'nslots' is rounded up to a power-of-2, and cannot exceed L3_MAX_SLOTS.
+ * Opening an already open channel returns the same channel. Channels are
+ * only supported by the L3_LOG_MMAP logging-type, after l3_init(). With
+ * other logging-types, l3_log_ch() logs like l3_log(). The l3_dump.py
+ * utility can list, filter and merge channels by name.
+ *
+ * Returns the channel; NULL on errors, with errno set.
+ */
+typedef struct l3_ring *l3_channel_t;
+
+#if defined(L3_LOGT_FPRINTF) || defined(L3_LOGT_WRITE)
+
+#define l3_log_ch(ch, msg, arg1, arg2) l3_log(msg, arg1, arg2)
+
+#elif defined(DEBUG)
+
+#define l3_log_ch(ch, msg, arg1, arg2)                                      \
+        if (1) {                                                            \
+            l3_log_ch_mmap((ch), L3_FMT(msg),                               \
+                           (uint64_t) (arg1), (uint64_t) (arg2),            \
+                           L3_LOC_ARG);                                     \
+        } else if (0) {                                                     \
+            printf((msg), (arg1), (arg2));                                  \
+        } else
+
+#else   // DEBUG
+
+#define l3_log_ch(ch, msg, arg1, arg2)                                      \
+        l3_log_ch_mmap((ch), L3_FMT(msg),                                   \
+                       (uint64_t) (arg1), (uint64_t) (arg2),                \
+                       L3_LOC_ARG)
+
+#endif  // L3_LOGT_FPRINTF || L3_LOGT_WRITE, DEBUG
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+l3_channel_t l3_channel_open(const char *name, uint32_t nslots);
+
+#ifdef L3_LOC_ENABLED
+void l3_log_ch_mmap(l3_channel_t ch, const char *msg, const uint64_t arg1,
+                    const uint64_t arg2, const loc_t loc);
+#else
+void l3_log_ch_mmap(l3_channel_t ch, const char *msg, const uint64_t arg1,
+                    const uint64_t arg2, const uint32_t loc);
+#endif  // L3_LOC_ENABLED
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * \brief Shared multi-process ring.
+ *
+ * Opt-in mode, for cooperating processes, e.g. clients and servers, to
+ * attach to one log-file at 'path' and log into its ring concurrently. The
+ * 1st process to attach creates the log-file. Each process records its pid
+ * and where its binary is loaded, so that the l3_dump.py utility decodes
+ * log-entries from different binaries in a single, globally ordered,
+ * timeline. Children created by fork() share the log-file too. Named
+ * channels cannot be opened, and only the sampled call-sites of the 1st
+ * process are described, in a shared log-file. Up to 64 processes can
+ * attach to a log-file; remove the log-file to start afresh.
+ *
+ * Returns 0 on success; -1 on errors, with errno set.
+ */
+#ifdef __cplusplus
+extern "C"
+#endif
+int l3_init_shared(const char *path);
+
+/**
+ * \brief NUMA-aware rings.
+ *
+ * Opt-in mode, for programs whose threads log from several NUMA nodes, e.g.
+ * of a 2-socket machine. Initializes logging to the log-file at 'path', as
+ * l3_init() does, but threads log, instead of to the default ring, to a ring
+ * of the NUMA node that they are running on, named "numa<node>". So, threads
+ * on different nodes do not contend for the cache-line of one ring's idx,
+ * nor store to slots on a remote node. The rings of all online nodes are
+ * opened here, from a pool separate from that of named channels, and are
+ * placed on their node by first-touch. Entries of the rings are timestamped,
+ * at the cost of a read of the timestamp-counter, and the l3_dump.py utility
+ * merges them chronologically.
+ *
+ * l3_log_str() and l3_log_bytes() still log to the default ring. Under
+ * l3_freeze_after(n), each ring is frozen after 'n' more entries of its own.
+ * Not supported on Mac/OSX, nor for log-files shared by l3_init_shared().
+ *
+ * Returns 0 on success; -1 on errors, with errno set, e.g. if a ring cannot
+ * be appended to the log-file, after which L3-logging is not initialized.
+ */
+#ifdef __cplusplus
+extern "C"
+#endif
+int l3_init_numa(const char *path);
+
+/**
+ * \brief Crash-time capture of the ring.
+ *
+ * Passing 'path' as NULL to l3_init() logs to an in-memory ring, which never
+ * touches the file-system. l3_init_crash_dump() pre-opens the file at 'path'
+ * and installs handlers for SIGSEGV, SIGABRT and SIGBUS, which write the
+ * ring, with its header, extension records and the map of loaded modules,
+ * to the file with a single writev() on a crash. The file can be unpacked by
+ * the l3_dump.py utility, like any L3-log file. The crash handlers run on an
+ * alternate signal-stack, to survive stack overflows. The calling thread
+ * gets one here; other threads get theirs on their 1st log-entry, unless
+ * they already have one. Threads that logged before this call do not, so a
+ * stack overflow in such a thread loses the crash-dump.
+ *
+ * Only supported by the L3_LOG_MMAP logging-type, after l3_init().
+ *
+ * Returns 0 on success; -1 on errors, with errno set.
+ */
+#ifdef __cplusplus
+extern "C"
+#endif
+int l3_init_crash_dump(const char *path);
+
+/**
+ * \brief Flight-recorder freeze: Preserve the history around an event.
+ *
+ * After an anomaly, e.g. an assertion, a latency outlier or an error return,
+ * the ring keeps rolling and overwrites the evidence within milliseconds.
+ * l3_freeze_after(n) lets 'n' more entries be logged and then freezes the
+ * ring, so that it holds exactly the window of entries around the trigger.
+ * l3_freeze() freezes the ring now. Named channels are frozen along with the
+ * ring. Writers to a frozen ring are redirected to a scratch ring, which is
+ * not dumped. l3_thaw() resumes logging to the ring.
+ *
+ * Only supported by the L3_LOG_MMAP logging-type, after l3_init().
+ *
+ * Returns 0 on success; -1 on errors, with errno set.
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int l3_freeze(void);
+int l3_freeze_after(uint64_t n);
+int l3_thaw(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * \brief Duration spans: Latency of a section of code, per call-site.
+ *
+ *  l3_span_t span = l3_span_begin("commit");
+ *  ...
+ *  l3_span_end("commit", span);
+ *
+ * l3_span_begin() logs a "Begin <name>" entry, with a span id unique to the
+ * calling thread and the timestamp-counter, and returns the span id.
+ * l3_span_end() logs the matching "End <name>" entry. 'name' must be a
+ * string literal. `l3_dump.py --spans` pairs the entries of each thread's
+ * spans, and reports latency percentiles (p50/p99/p999/max), a histogram
+ * per span name, and spans whose begin, or end, is not found in the ring.
+ *
+ * Only supported by the L3_LOG_MMAP logging-type, after l3_init(). With
+ * other logging-types, spans are not logged.
+ */
+typedef uint64_t l3_span_t;
+
+#define L3_SPAN_BEGIN_MSG(name) "Begin " name ": span=%" PRIu64 ", tsc=%" PRIu64
+#define L3_SPAN_END_MSG(name)   "End " name ": span=%" PRIu64 ", tsc=%" PRIu64
+
+#if defined(L3_LOGT_FPRINTF) || defined(L3_LOGT_WRITE)
+
+#define l3_span_begin(name)         ((l3_span_t) 0)
+#define l3_span_end(name, span)     ((void) (span))
+
+#else   // L3_LOGT_FPRINTF || L3_LOGT_WRITE
+
+#define l3_span_begin(name)                                                 \
+        l3_span_begin_mmap(L3_FMT(L3_SPAN_BEGIN_MSG(name)), L3_LOC_ARG)
+
+#define l3_span_end(name, span)                                             \
+        l3_span_end_mmap(L3_FMT(L3_SPAN_END_MSG(name)), (span), L3_LOC_ARG)
+
+#endif  // L3_LOGT_FPRINTF || L3_LOGT_WRITE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef L3_LOC_ENABLED
+l3_span_t l3_span_begin_mmap(const char *msg, const loc_t loc);
+void l3_span_end_mmap(const char *msg, l3_span_t span, const loc_t loc);
+#else
+l3_span_t l3_span_begin_mmap(const char *msg, const uint32_t loc);
+void l3_span_end_mmap(const char *msg, l3_span_t span, const uint32_t loc);
+#endif  // L3_LOC_ENABLED
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * \brief Per-call-site sampling and rate-limiting of L3-logging.
+ *
+ * Hot call-sites that fire millions of times per second quickly flush all
+ * useful history out of the ring-buffer. These caller-macros apply a
+ * sampling policy to a single call-site, using a per-site thread-local
+ * counter, so that the check is cheaper than the log itself:
+ *
+ *  - l3_log_every_n(n, ...)        : Log 1-in-n calls.
+ *  - l3_log_first_k(k, n, ...)     : Log the first k calls, then 1-in-n.
+ *  - l3_log_max_rate(rate, ...)    : Token-bucket; at most 'rate' logs/sec.
+ *
+ * Counters and token-buckets are per-thread, so the policy applies to each
+ * thread independently. The arguments n, k and rate must be compile-time
+ * constants, and n and rate must be at least 1, as asserted at compile-time.
+ * Each call-site also emits a descriptor of its policy into the
+ * 'l3_sample_sites' section, which l3_init() copies into the log-file so
+ * that l3_dump.py can report the sampling ratio of each entry.
+ */
+typedef enum {
+      L3_SAMPLE_NONE    = 0
+    , L3_SAMPLE_EVERY_N         // Log 1-in-n calls
+    , L3_SAMPLE_FIRST_K         // Log first k calls, then 1-in-n
+    , L3_SAMPLE_MAX_RATE        // Log at most n calls / second
+} l3_sample_policy_t;
+
+/**
+ * Descriptor of a sampled call-site. The L3-dump script expects this layout.
+ * Descriptors are laid out as an array in their ELF-section, so they are
+ * explicitly sized and aligned to avoid any compiler-inserted padding.
+ */
+typedef struct l3_sample_site
+{
+    const char *msg;
+    uint32_t    policy;     // One of l3_sample_policy_t
+    uint32_t    k;          // L3_SAMPLE_FIRST_K: # of calls always logged
+    uint64_t    n;          // Sampling ratio (1-in-n), or max-rate / sec.
+    uint64_t    pad0;
+} L3_SAMPLE_SITE;
+
+#define L3_SAMPLE_SITE_ALIGN    32
+
+/**
+ * Per-thread, per-call-site token-bucket for L3_SAMPLE_MAX_RATE sites.
+ */
+typedef struct l3_rate_state
+{
+    uint64_t    tokens;
+    uint64_t    last_ns;
+} L3_RATE_STATE;
+
+// Define version of static assertion checking that works for both gcc and g++
+#ifdef __cplusplus
+#define L3_STATIC_ASSERT    static_assert
+#else
+#define L3_STATIC_ASSERT    _Static_assert
+#endif
+
+#if __APPLE__
+#define L3_SECTION(name)    __attribute__((section("__DATA," name), used))
+#else
+#define L3_SECTION(name)    __attribute__((section(name), used))
+#endif  // __APPLE__
+
+#define L3_SAMPLE_SITE_DEFINE(policy, k, n, msg)                            \
+        static const L3_SAMPLE_SITE l3_sample_site_                         \
+                L3_SECTION("l3_sample_sites")                               \
+                __attribute__((aligned(L3_SAMPLE_SITE_ALIGN)))              \
+                = { (msg), (policy), (k), (n), 0 }
+
+#define l3_log_every_n(n, msg, arg1, arg2)                                  \
+        do {                                                                \
+            L3_STATIC_ASSERT((n) >= 1, "Sampling ratio n must be >= 1");    \
+            L3_SAMPLE_SITE_DEFINE(L3_SAMPLE_EVERY_N, 0, (n), (msg));        \
+            static __thread uint64_t l3_skip_;                              \
+            if (l3_skip_-- == 0) {                                          \
+                l3_skip_ = (n) - 1;                                         \
+                l3_log((msg), (arg1), (arg2));                              \
+            }                                                               \
+        } while (0)
+
+#define l3_log_first_k(k, n, msg, arg1, arg2)                               \
+        do {                                                                \
+            L3_STATIC_ASSERT((n) >= 1, "Sampling ratio n must be >= 1");    \
+            L3_SAMPLE_SITE_DEFINE(L3_SAMPLE_FIRST_K, (k), (n), (msg));      \
+            static __thread uint64_t l3_seen_;                              \
+            static __thread uint64_t l3_skip_;                              \
+            if (l3_seen_ < (k)) {                                           \
+                l3_seen_++;                                                 \
+                l3_log((msg), (arg1), (arg2));                              \
+            } else if (l3_skip_-- == 0) {                                   \
+                l3_skip_ = (n) - 1;                                         \
+                l3_log((msg), (arg1), (arg2));                              \
+            }                                                               \
+        } while (0)
+
+#define l3_log_max_rate(rate, msg, arg1, arg2)                              \
+        do {                                                                \
+            L3_STATIC_ASSERT((rate) > 0, "Max-rate must be > 0");           \
+            L3_SAMPLE_SITE_DEFINE(L3_SAMPLE_MAX_RATE, 0, (rate), (msg));    \
+            static __thread L3_RATE_STATE l3_bucket_;                       \
+            if (   l3_bucket_.tokens                                        \
+                || l3_sample_rate_refill(&l3_bucket_, (rate))) {            \
+                l3_bucket_.tokens--;                                        \
+                l3_log((msg), (arg1), (arg2));                              \
+            }                                                               \
+        } while (0)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int l3_sample_rate_refill(L3_RATE_STATE *bucket, const uint64_t rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * \brief Call-site hit counters.
+ *
+ * When compiled with -DL3_SITE_COUNTERS, each l3_log() call-site counts how
+ * often it fires, including the hits whose log-entries have long been
+ * overwritten in the ring. Each call-site emits a descriptor, with its
+ * message and source location, into the 'l3_log_sites' section. Each thread
+ * counts hits in its own array of counters, indexed by the descriptor's
+ * position in the section, so that counting never contends across threads.
+ * l3_stats() sums the counters of all threads, including those that have
+ * exited, and prints the 'ntop' call-sites with the most hits, and their
+ * rates since the 1st hit, to 'fh'. These report which call-sites to sample
+ * or demote. Not supported on Mac/OSX.
+ *
+ * Returns 0 on success; -1 on errors, with errno set.
+ */
+typedef struct l3_site
+{
+    const char *msg;
+    const char *file;
+    uint32_t    line;
+    uint32_t    pad0;
+    uint64_t    pad1;
+} L3_SITE;
+
+#define L3_SITE_ALIGN   32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const L3_SITE __start_l3_log_sites[] __attribute__((weak));
+extern const L3_SITE __stop_l3_log_sites[] __attribute__((weak));
+
+extern __thread uint64_t *l3_site_hits;     // This thread's counters
+
+uint64_t *l3_site_hits_init(void);
+int l3_stats(FILE *fh, uint32_t ntop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define L3_SITE_HIT(msg)                                                    \
+        do {                                                                \
+            static const L3_SITE l3_site_                                   \
+                    L3_SECTION("l3_log_sites")                              \
+                    __attribute__((aligned(L3_SITE_ALIGN)))                 \
+                    = { (msg), __FILE__, __LINE__, 0, 0 };                  \
+            uint64_t *l3_hits_ = l3_site_hits;                              \
+            if (__builtin_expect((l3_hits_ != NULL), 1)                     \
+                || (l3_hits_ = l3_site_hits_init())) {                      \
+                l3_hits_[&l3_site_ - __start_l3_log_sites]++;               \
+            }                                                               \
+        } while (0)
+
+/**
+ * \brief Typed arguments: Descriptors of the types of the arguments logged.
+ *
+ * Call-sites of the C++20 front end, l3::log<>(), below, of l3_log_str() and
+ * of l3_log_bytes(), above, emit a descriptor of the types of their arguments
+ * into the 'l3_arg_types' section, so that the l3_dump.py utility decodes the
+ * raw bits logged, e.g. of doubles and of negative integers, by their type,
+ * rather than by guessing from the format string. l3_init() copies the
+ * descriptors into the log-file. The L3-dump script expects this layout. Not
+ * supported on Mac/OSX.
+ */
+typedef enum {
+      L3_ARG_NONE       = 0     // No argument
+    , L3_ARG_INT                // Signed integer, sign-extended
+    , L3_ARG_UINT               // Unsigned integer, or bool
+    , L3_ARG_DOUBLE             // Bits of a double
+    , L3_ARG_PTR                // Pointer
+    , L3_ARG_CHAR               // char
+    , L3_ARG_STR                // Bytes copied, and string, by l3_log_str()
+    , L3_ARG_BYTES              // Bytes copied, and tag, by l3_log_bytes()
+} l3_arg_type_t;
+
+typedef struct l3_arg_types
+{
+    const char *msg;
+    uint8_t     arg1;       // One of l3_arg_type_t
+    uint8_t     arg2;
+    uint8_t     pad0[6];
+} L3_ARG_TYPES;
+
+#define L3_ARG_TYPES_ALIGN  16
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const L3_ARG_TYPES __start_l3_arg_types[] __attribute__((weak));
+extern const L3_ARG_TYPES __stop_l3_arg_types[] __attribute__((weak));
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * \brief Source locations: Per-site descriptors of call-sites of the C++20
+ * front end, l3_log_srcloc(), below.
+ *
+ * The descriptor is a static, filled-in at compile-time from
+ * std::source_location::current(). Its address, as an offset from the
+ * program's base-address, is logged in the loc field of the entry. Pointers
+ * to descriptors are emitted into the 'l3_src_locs' section, from which
+ * l3_init() copies them, and their strings, into the log-file, for the
+ * l3_dump.py utility to decode. Not supported on Mac/OSX.
+ */
+typedef struct l3_src_loc
+{
+    const char *file;
+    const char *function;
+    uint32_t    line;
+    uint32_t    column;
+} L3_SRC_LOC;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const L3_SRC_LOC *const __start_l3_src_locs[] __attribute__((weak));
+extern const L3_SRC_LOC *const __stop_l3_src_locs[] __attribute__((weak));
+
+extern uint64_t l3_fbase;   // Base-address of program's binary
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * \brief Type-safe C++20 front end to L3-logging.
+ *
+ *  l3::log<"Read {} bytes, in {} secs">(nbytes, secs);
+ *
+ * Each '{}' in the format string, a template argument, is replaced by one of
+ * the arguments, of which there can be up to 2. Literal braces are written
+ * as '{{' and '}}'. The # of arguments, and their types, are checked at
+ * compile-time: Each must be an integer, bool, enum, floating-point number,
+ * pointer or char. The format string is translated, at compile-time, into a
+ * printf() format string that describes the arguments' types, e.g. "%ld",
+ * "%lu", "%g", "%p" or "%c", which is the msg logged. So the string is stored
+ * once, in rodata, with the descriptor of the call-site's argument types. At
+ * run-time, the arguments' bits are logged, as they are, with no formatting
+ * nor casts by the caller, as by l3_log().
+ *
+ * Only supported by the L3_LOG_MMAP logging-type, after l3_init().
+ */
+#if defined(__cplusplus) && (__cplusplus >= 202002L)
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <source_location>
+#include <type_traits>
+
+namespace l3 {
+
+/**
+ * Format string, as a template argument.
+ */
+template <std::size_t N>
+struct fmt_string
+{
+    char str[N] = {};
+
+    consteval fmt_string(const char (&s)[N])
+    {
+        for (std::size_t i = 0; i < N; i++) {
+            str[i] = s[i];
+        }
+    }
+};
+
+/**
+ * l3_arg_type_t of an argument of type T, or L3_ARG_NONE if it cannot be
+ * logged.
+ */
+template <typename T>
+consteval l3_arg_type_t
+arg_type()
+{
+    if constexpr (std::is_same_v<T, char>) {
+        return L3_ARG_CHAR;
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return L3_ARG_UINT;
+    } else if constexpr (std::is_enum_v<T>) {
+        return arg_type<std::underlying_type_t<T>>();
+    } else if constexpr (std::is_integral_v<T> && (sizeof(T) <= sizeof(uint64_t))) {
+        return (std::is_signed_v<T> ? L3_ARG_INT : L3_ARG_UINT);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return L3_ARG_DOUBLE;
+    } else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>) {
+        return L3_ARG_PTR;
+    } else {
+        return L3_ARG_NONE;
+    }
+}
+
+/**
+ * printf() conversion specifier for an argument of l3_arg_type_t 'type'.
+ */
+constexpr const char *
+arg_spec(l3_arg_type_t type)
+{
+    switch (type) {
+      case L3_ARG_INT:      return "%ld";
+      case L3_ARG_UINT:     return "%lu";
+      case L3_ARG_DOUBLE:   return "%g";
+      case L3_ARG_PTR:      return "%p";
+      case L3_ARG_CHAR:     return "%c";
+      default:              return "";
+    }
+}
+
+/**
+ * Translate the format string 'fmt' into a printf() format string for
+ * 'ntypes' arguments of 'types', into 'out', if given. Returns the # of
+ * chars of the translated string, excluding the NUL, or -1 if a brace is
+ * not paired.
+ */
+template <std::size_t N>
+constexpr long
+fmt_translate(const fmt_string<N> &fmt, const l3_arg_type_t *types,
+              std::size_t ntypes, char *out = nullptr)
+{
+    long len = 0;
+    std::size_t argn = 0;
+    auto put = [&](const char *s) {
+        for (; *s; s++, len++) {
+            if (out) {
+                out[len] = *s;
+            }
+        }
+    };
+    for (std::size_t i = 0; (i < N) && fmt.str[i]; i++) {
+        char c = fmt.str[i];
+        char next = (((i + 1) < N) ? fmt.str[i + 1] : '\0');
+        if ((c == '{') && (next == '}')) {
+            put((argn < ntypes) ? arg_spec(types[argn]) : "");
+            argn++;
+            i++;
+        } else if (((c == '{') || (c == '}')) && (next == c)) {
+            put((c == '{') ? "{" : "}");
+            i++;
+        } else if ((c == '{') || (c == '}')) {
+            return -1;
+        } else if (c == '%') {
+            put("%%");
+        } else {
+            char s[] = { c, '\0' };
+            put(s);
+        }
+    }
+    return len;
+}
+
+/**
+ * # of '{}' placeholders in the format string 'fmt'.
+ */
+template <std::size_t N>
+constexpr std::size_t
+fmt_nargs(const fmt_string<N> &fmt)
+{
+    std::size_t nargs = 0;
+    for (std::size_t i = 0; (i + 1) < N; i++) {
+        if ((fmt.str[i] == '{') && (fmt.str[i + 1] == '}')) {
+            nargs++;
+            i++;
+        } else if ((fmt.str[i] == fmt.str[i + 1])
+                   && ((fmt.str[i] == '{') || (fmt.str[i] == '}'))) {
+            i++;
+        }
+    }
+    return nargs;
+}
+
+/**
+ * The translated format string, of a call-site logging arguments of
+ * 'Types', stored once in rodata.
+ */
+template <fmt_string Fmt, l3_arg_type_t... Types>
+struct typed_fmt
+{
+    static constexpr l3_arg_type_t types[] = { Types..., L3_ARG_NONE, L3_ARG_NONE };
+
+    static constexpr std::size_t ntypes = sizeof...(Types);
+
+    static constexpr long len = fmt_translate(Fmt, types, ntypes);
+
+    static constexpr auto value = []() {
+        std::array<char, ((len < 0) ? 1 : (len + 1))> str = {};
+        if constexpr (len >= 0) {
+            fmt_translate(Fmt, types, ntypes, str.data());
+        }
+        return str;
+    }();
+};
+
+/**
+ * Raw bits of an argument, as logged.
+ */
+template <typename T>
+inline uint64_t
+arg_bits(T arg)
+{
+    if constexpr (std::is_floating_point_v<T>) {
+        return std::bit_cast<uint64_t>(static_cast<double>(arg));
+    } else if constexpr (std::is_null_pointer_v<T>) {
+        return 0;
+    } else if constexpr (std::is_pointer_v<T>) {
+        return reinterpret_cast<uintptr_t>(arg);
+    } else if constexpr (std::is_enum_v<T>) {
+        return static_cast<uint64_t>(static_cast<std::underlying_type_t<T>>(arg));
+    } else {
+        return static_cast<uint64_t>(arg);
+    }
+}
+
+#ifdef L3_LOC_ENABLED
+using loc_arg_t = loc_t;
+#else
+using loc_arg_t = uint32_t;
+#endif  // L3_LOC_ENABLED
+
+/**
+ * l3::log_at<"fmt {}">(loc, args...) - Log the arguments, checked against the
+ * format string at compile-time, with the call-site's 'loc'.
+ */
+template <fmt_string Fmt, typename... Args>
+__attribute__((always_inline)) inline void
+log_at(const loc_arg_t loc, Args... args)
+{
+    static_assert(fmt_translate(Fmt, nullptr, 0) >= 0,
+                  "l3::log(): Unpaired '{' or '}' in format string; "
+                  "use '{{' or '}}' for literal braces.");
+    static_assert(sizeof...(Args) <= 2,
+                  "l3::log(): At most 2 arguments can be logged.");
+    static_assert(sizeof...(Args) == fmt_nargs(Fmt),
+                  "l3::log(): # of arguments != # of '{}' in format string.");
+    static_assert(((arg_type<Args>() != L3_ARG_NONE) && ...),
+                  "l3::log(): Arguments must be integers, floating-point "
+                  "numbers, pointers or chars.");
+
+    using site = typed_fmt<Fmt, arg_type<Args>()...>;
+    constexpr const char *msg = site::value.data();
+
+#if !__APPLE__
+    // As L3_FMT(), and a L3_ARG_TYPES{} descriptor. The "X" constraint, unlike
+    // "i", also accepts the address of the string under -fPIC.
+    __asm__(".pushsection l3_log_fmts, \"aw\"\n\t"
+            ".quad %p0\n\t"
+            ".popsection\n\t"
+            ".pushsection l3_arg_types, \"aw\"\n\t"
+            ".balign %c3\n\t"
+            ".quad %p0\n\t"
+            ".byte %c1, %c2, 0, 0, 0, 0, 0, 0\n\t"
+            ".popsection"
+            : : "X" (msg), "i" (site::types[0]), "i" (site::types[1]),
+                "i" (L3_ARG_TYPES_ALIGN));
+#endif  // !__APPLE__
+
+    uint64_t bits[] = { arg_bits(args)..., 0, 0 };
+    l3_log_mmap(msg, bits[0], bits[1], loc);
+}
+
+/**
+ * l3::log<"fmt {}">(args...) - Log the arguments, checked against the format
+ * string at compile-time.
+ */
+template <fmt_string Fmt, typename... Args>
+__attribute__((always_inline)) inline void
+log(Args... args)
+{
+    log_at<Fmt>(L3_ARG_UNUSED, args...);
+}
+
+/**
+ * L3_SRC_LOC{} descriptor of the call-site at 'loc'.
+ */
+consteval L3_SRC_LOC
+src_loc(const std::source_location loc)
+{
+    return L3_SRC_LOC{ loc.file_name(), loc.function_name(),
+                       loc.line(), loc.column() };
+}
+
+}   // namespace l3
+
+/**
+ * \brief C++20 source-location front end to L3-logging.
+ *
+ *  l3_log_srcloc("Read {} bytes, in {} secs", nbytes, secs);
+ *
+ * As l3::log<>(), and the entry also identifies the call-site, by its file,
+ * line, column and function, as reported by std::source_location::current().
+ * These are interned, at compile-time, in a static L3_SRC_LOC{} descriptor
+ * per call-site; at run-time, only the descriptor's offset from the program's
+ * base-address is logged, in the loc field of the entry. So, call-sites are
+ * identified as with LOC-encoding, without the LineOfCode generator.
+ *
+ * Builds that already use the loc field, for LOC-encoding, L3_LOC_RETADDR or
+ * L3_CPUID_ENABLED, or have no room for it, under L3_MSGID_ENABLED, log it as
+ * usual, instead.
+ */
+#if defined(L3_LOC_ENABLED) || defined(L3_LOC_RETADDR) || defined(L3_MSGID_ENABLED) \
+    || defined(L3_CPUID_ENABLED) || __APPLE__
+
+#define l3_log_srcloc(fmt, ...)                                             \
+        l3::log_at<fmt>(L3_LOC_ARG __VA_OPT__(,) __VA_ARGS__)
+
+#else
+
+#define l3_log_srcloc(fmt, ...)                                             \
+        do {                                                                \
+            static constexpr L3_SRC_LOC l3_src_loc_                         \
+                    = l3::src_loc(std::source_location::current());         \
+            __asm__(".pushsection l3_src_locs, \"aw\"\n\t"                  \
+                    ".quad %p0\n\t"                                         \
+                    ".popsection"                                           \
+                    : : "X" (&l3_src_loc_));                                \
+            l3::log_at<fmt>((uint32_t) ((uintptr_t) &l3_src_loc_ - l3_fbase) \
+                            __VA_OPT__(,) __VA_ARGS__);                     \
+        } while (0)
+
+#endif  // L3_LOC_ENABLED || L3_LOC_RETADDR || L3_MSGID_ENABLED || L3_CPUID_ENABLED || __APPLE__
+
+#endif  // __cplusplus >= 202002L
@@ -14,12 +14,42 @@ import shutil
 import re
 import shlex
 import argparse
+import io
+import heapq
+import json
+import functools
+import mmap
+import bisect
+import importlib.util
+import errno
+import uuid
 
 # ##############################################################################
 # Constants that tie the unpacking logic to L3's core structure's layout
 # ##############################################################################
 L3_LOG_HEADER_SZ = 32  # bytes; offsetof(L3_LOG, slots)
 L3_ENTRY_SZ = 32       # bytes; sizeof(L3_ENTRY)
+L3_EXT_HDR_SZ = 16     # bytes; sizeof(L3_EXT)
+L3_SAMPLE_SITE_SZ = 32 # bytes; sizeof(L3_SAMPLE_SITE)
+L3_RING_HDR_SZ = 64    # bytes; offsetof(L3_RING, slots)
+L3_XENTRY_SZ = 48      # bytes; sizeof(L3_XENTRY)
+L3_MODULE_SZ = 256     # bytes; sizeof(L3_MODULE)
+L3_PROCS_HDR_SZ = 16   # bytes; offsetof(L3_PROCS, procs)
+L3_PROC_SZ = 256       # bytes; sizeof(L3_PROC)
+L3_CLOCK_SZ = 32       # bytes; sizeof(L3_CLOCK)
+L3_STRING_HDR_SZ = 16  # bytes; sizeof(L3_STRING)
+L3_ARG_TYPES_SZ = 16   # bytes; sizeof(L3_ARG_TYPES)
+L3_SRC_LOC_REC_HDR_SZ = 32  # bytes; sizeof(L3_SRC_LOC_REC)
+
+L3_CHANNEL_MAP_SZ = 32 # bytes; sizeof(L3_CHANNEL_MAP)
+L3_ENTRY_CONT_LEN = 28 # bytes; sizeof(L3_ENTRY_CONT.str)
+
+# Name reported for log-entries from the default ring-buffer in L3_LOG{}
+L3_RING_DEFAULT_NAME = 'default'
+
+# Prefix of the names of the rings of NUMA nodes, "numa<node>", which stand
+# in for the default ring-buffer under l3_init_numa().
+L3_RING_NUMA_PREFIX = 'numa'
 
 # #############################################################################
 PROGRAM_BIN = 'unknown'
@@ -36,6 +66,8 @@ LOC_DECODER = "LOC_DECODER"
 L3_LOC_UNSET            = 0
 L3_LOC_DEFAULT          = 1
 L3_LOC_ELF_ENCODING     = 2
+L3_LOC_RETADDR          = 3     # Return address of call-site, not LOC-encoding
+L3_LOC_CPUID            = 4     # CPU # of the log-entry, not LOC-encoding
 
 # #############################################################################
 # Establish path / names to tools used here based on the OS-platform version
@@ -69,6 +101,47 @@ L3_LOG_PLATFORM_MACOSX          = 2
 L3_LOG_LOC_NONE                 = 0
 L3_LOG_LOC_ENCODING             = 1
 L3_LOG_LOC_ELF_ENCODING         = 2
+L3_LOG_LOC_RETADDR              = 3
+L3_LOG_LOC_CPUID                = 4
+
+# Enum ext_type_t defined in src/l3.c for L3_EXT()->type field
+L3_EXT_END                      = 0
+L3_EXT_SAMPLE_SITES             = 1
+L3_EXT_RING                     = 2
+L3_EXT_MODULES                  = 3
+L3_EXT_PROCS                    = 4
+L3_EXT_CLOCK                    = 5
+L3_EXT_STRINGS                  = 6
+L3_EXT_ARG_TYPES                = 7
+L3_EXT_SRC_LOCS                 = 8
+L3_EXT_PAD                      = 9
+
+# Flags defined in src/l3.c for L3_LOG()->flags field
+L3_LOG_FLAG_SHARED              = 0x1
+L3_LOG_FLAG_MSGID               = 0x2
+L3_LOG_FLAG_NUMA                = 0x4
+
+# Slot # of the process, sharing a log-file, stashed in the tid logged.
+L3_PROC_SLOT_SHIFT              = 22
+
+# Slot # of the process that created a shared log-file, and its extensions.
+L3_PROC_SLOT_CREATOR            = 1
+
+# Enum l3_sample_policy_t defined in include/l3.h for L3_SAMPLE_SITE()->policy
+L3_SAMPLE_NONE                  = 0
+L3_SAMPLE_EVERY_N               = 1
+L3_SAMPLE_FIRST_K               = 2
+L3_SAMPLE_MAX_RATE              = 3
+
+# Enum l3_arg_type_t defined in include/l3.h for L3_ARG_TYPES()->arg{1,2}
+L3_ARG_NONE                     = 0
+L3_ARG_INT                      = 1
+L3_ARG_UINT                     = 2
+L3_ARG_DOUBLE                   = 3
+L3_ARG_PTR                      = 4
+L3_ARG_CHAR                     = 5
+L3_ARG_STR                      = 6
+L3_ARG_BYTES                    = 7
 
 # #############################################################################
 def which_binary(os_uname_s:str, bin_name:str):
@@ -246,165 +319,1846 @@ def l3_unpack_loghdr(file_hdl) -> (int, int, int):
         uint16_t        log_size;   // # of log-entries == L3_MAX_SLOTS
         uint8_t         platform;
         uint8_t         loc_type;
-        uint64_t        pad1;
+        uint64_t        freeze_idx;
         L3_ENTRY        slots[L3_MAX_SLOTS];
     } L3_LOG;
 
-    Arguments:
-        file_hdl    - Handle to open log-file
+    Arguments:
+        file_hdl    - Handle to open log-file
+
+    Returns: Tuple of 3-ints: (fibase, l3_platform, decode_loc_id)
+    """
+    data = file_hdl.read(L3_LOG_HEADER_SZ)
+
+    # '<' => byte-order of the header is little-endian
+    # See: https://docs.python.org/3/library/struct.html
+    # pylint: disable-next=unused-variable
+    (_, fibase, pad0, pad2, l3_platform, loc_type, _) = struct.unpack('<QQihBBQ', data)
+
+    # Interpret LOC-encoding scheme flag as loc-encoding type-ID
+    if loc_type == L3_LOG_LOC_ENCODING:
+        decode_loc_id = L3_LOC_DEFAULT
+    elif loc_type == L3_LOG_LOC_ELF_ENCODING:
+        decode_loc_id = L3_LOC_ELF_ENCODING
+    elif loc_type == L3_LOG_LOC_RETADDR:
+        decode_loc_id = L3_LOC_RETADDR
+    elif loc_type == L3_LOG_LOC_CPUID:
+        decode_loc_id = L3_LOC_CPUID
+    else:
+        decode_loc_id = L3_LOC_UNSET
+
+    # DEBUG: print(f"{l3_platform=}, {decode_loc_id=}")
+    return (fibase, l3_platform, decode_loc_id)
+
+
+# #############################################################################
+def l3_unpack_logsize(file_hdl) -> (int, int):
+    """
+    Unpack the fields of the L3-log header that describe the ring-buffer:
+    the # of log-entries logged, i.e. L3_LOG()->idx, and the # of slots
+    in the ring-buffer. Leaves the file positioned at the 1st log-entry.
+
+    Returns: Tuple of 2-ints: (idx, log_size)
+    """
+    file_hdl.seek(0)
+    data = file_hdl.read(L3_LOG_HEADER_SZ)
+    # pylint: disable-next=unused-variable
+    (idx, _, _, log_size, _, _, freeze_idx) = struct.unpack('<QQiHBBQ', data)
+    return (l3_frozen_idx(idx, freeze_idx), log_size)
+
+# #############################################################################
+def l3_unpack_logflags(file_hdl) -> int:
+    """
+    Unpack the L3_LOG()->flags field of the L3-log header.
+
+    Returns: Int: L3_LOG_FLAG_* bits
+    """
+    file_hdl.seek(0)
+    data = file_hdl.read(L3_LOG_HEADER_SZ)
+    (_, _, flags, _, _, _, _) = struct.unpack('<QQIHBBQ', data)
+    return flags
+
+# #############################################################################
+def l3_frozen_idx(idx:int, freeze_idx:int) -> int:
+    """
+    Writers to a ring frozen by l3_freeze() / l3_freeze_after() consume
+    idx's beyond its freeze_idx, but do not log to the ring. freeze_idx is
+    L3_UNFROZEN, or 0 in older log-files, if the ring was never frozen.
+
+    Returns: The # of log-entries logged to the ring, up to its freeze_idx.
+    """
+    if 0 < freeze_idx < idx:
+        return freeze_idx
+    return idx
+
+# #############################################################################
+def l3_unpack_ring_hdr(payload) -> (int, int, str):
+    """
+    Unpack the L3_RING{} header of a named ring from its extension record.
+
+    Returns: Tuple: (idx, nslots, name), where idx is the # of log-entries
+             logged to the ring, up to its freeze_idx.
+    """
+    (idx, nslots, _, freeze_idx, name) = struct.unpack_from('<QIIQ40s', payload, 0)
+    name = name.split(b'\0', 1)[0].decode(errors='ignore')
+    return (l3_frozen_idx(idx, freeze_idx), nslots, name)
+
+# #############################################################################
+def l3_read_view(file_hdl, size:int):
+    """
+    Read 'size' bytes from the current position of the file. Of a log-file
+    mapped by mmap, return a view of its mapping, instead of a copy.
+
+    Returns: memoryview, or bytes
+    """
+    if not isinstance(file_hdl, mmap.mmap):
+        return file_hdl.read(size)
+
+    offs = file_hdl.tell()
+    size = max(0, min(size, file_hdl.size() - offs))
+    file_hdl.seek(offs + size)
+    return memoryview(file_hdl)[offs:(offs + size)]
+
+# #############################################################################
+def l3_unpack_exts(file_hdl, log_size:int) -> list:
+    """
+    Unpack the sequence of L3_EXT{} extension records, that follow the
+    ring-buffer of log-entries in the L3-log file. We are unpacking a
+    struct laid out like the following, followed by 'size' bytes of payload:
+
+    typedef struct l3_ext
+    {
+        uint32_t        type;
+        uint32_t        pad0;
+        uint64_t        size;
+    } L3_EXT;
+
+    Log-files generated by older versions of L3 have no extension records.
+    Leaves the file positioned at the 1st log-entry.
+
+    Returns: List of tuples (type, payload-bytes), in file-order.
+    """
+    exts = []
+    file_hdl.seek(L3_LOG_HEADER_SZ + (log_size * L3_ENTRY_SZ))
+    while True:
+        data = file_hdl.read(L3_EXT_HDR_SZ)
+        if len(data) < L3_EXT_HDR_SZ:
+            break
+
+        (ext_type, _, size) = struct.unpack('<IIQ', data)
+        if ext_type == L3_EXT_END:
+            break
+
+        # Rings are the bulk of a log-file, so are not copied from a mapped
+        # log-file; Their pages are read in as their entries are unpacked.
+        payload = l3_read_view(file_hdl, size) if ext_type == L3_EXT_RING \
+                  else file_hdl.read(size)
+        if len(payload) < size:
+            break
+        exts.append((ext_type, payload))
+
+    file_hdl.seek(L3_LOG_HEADER_SZ)
+    return exts
+
+# #############################################################################
+def l3_unpack_sample_sites(exts:list) -> dict:
+    """
+    Unpack the array of L3_SAMPLE_SITE{} descriptors, for call-sites logging
+    through one of the sampling caller-macros, l3_log_every_n() etc.
+
+    typedef struct l3_sample_site
+    {
+        const char *msg;
+        uint32_t    policy;
+        uint32_t    k;
+        uint64_t    n;
+        uint64_t    pad0;
+    } L3_SAMPLE_SITE;
+
+    Returns: Dictionary mapping {msg-ptr: (policy, k, n)}
+    """
+    sites = {}
+    for (ext_type, payload) in exts:
+        if ext_type != L3_EXT_SAMPLE_SITES:
+            continue
+        for offs in range(0, len(payload) - L3_SAMPLE_SITE_SZ + 1, L3_SAMPLE_SITE_SZ):
+            (msgptr, policy, k, n) = struct.unpack_from('<QIIQ', payload, offs)
+            if msgptr != 0:
+                sites[msgptr] = (policy, k, n)
+    return sites
+
+# #############################################################################
+def l3_unpack_arg_types(exts:list) -> dict:
+    """
+    Unpack the array of L3_ARG_TYPES{} descriptors, for call-sites logging
+    through the C++20 front end, l3::log<>().
+
+    typedef struct l3_arg_types
+    {
+        const char *msg;
+        uint8_t     arg1;
+        uint8_t     arg2;
+        uint8_t     pad0[6];
+    } L3_ARG_TYPES;
+
+    Returns: Dictionary mapping {msg-ptr: (arg1-type, arg2-type)}
+    """
+    arg_types = {}
+    for (ext_type, payload) in exts:
+        if ext_type != L3_EXT_ARG_TYPES:
+            continue
+        for offs in range(0, len(payload) - L3_ARG_TYPES_SZ + 1, L3_ARG_TYPES_SZ):
+            (msgptr, arg1_type, arg2_type) = struct.unpack_from('<QBB', payload, offs)
+            if msgptr != 0:
+                arg_types[msgptr] = (arg1_type, arg2_type)
+    return arg_types
+
+# #############################################################################
+def l3_unpack_default_ring(file_hdl, idx:int, log_size:int,
+                           msgids:bool = False):
+    """
+    Unpack the log-entries of the default ring-buffer in L3_LOG{}, oldest
+    first. Of the 'idx' entries ever logged, the ring-buffer retains the
+    last 'log_size' entries; entry # 'seq' is found at slot (seq % log_size).
+
+    If 'msgids', i.e. L3_LOG_FLAG_MSGID, the entries are laid out as:
+
+    typedef struct l3_entry
+    {
+        pid_t       tid;
+        uint32_t    msgid;
+        uint64_t    tsc;
+        uint64_t    arg1;
+        uint64_t    arg2;
+    } L3_ENTRY;
+
+    Their msgid, i.e. the offset of msg from the base-address of the binary
+    that logged it, is returned as the msgptr, with a loc of 0.
+
+    Continuation entries, following an entry logged by l3_log_str(), carry
+    more bytes of its string, and are identified by their negative tid, ~tid
+    of the writer:
+
+    typedef struct l3_entry_cont
+    {
+        pid_t       ntid;
+        char        str[28];
+    } L3_ENTRY_CONT;
+
+    They are appended to the arg2 of the entry they follow, which is returned
+    as the bytes of the string, instead.
+
+    The slots are read here, but entries are unpacked as they are iterated.
+
+    Returns: Iterator of log-entries, in the form merged by l3_merge_rings().
+    """
+    file_hdl.seek(L3_LOG_HEADER_SZ)
+    data = l3_read_view(file_hdl, log_size * L3_ENTRY_SZ)
+    return l3_default_ring_entries(data, idx, msgids)
+
+# #############################################################################
+def l3_default_ring_entries(data, idx:int, msgids:bool):
+    """
+    Unpack the log-entries of the default ring, from its slots 'data', as
+    described by l3_unpack_default_ring(). An entry is held back until the
+    next one, so that continuation entries can be appended to it.
+
+    Yields: Log-entries, in the form merged by l3_merge_rings().
+    """
+    nslots = len(data) // L3_ENTRY_SZ
+    if nslots == 0:
+        return
+
+    # Entry held back, and seq and tid of the last entry, or continuation
+    # entry, unpacked.
+    entry = None
+    last = None
+    for seq in range(max(0, idx - nslots), idx):
+        offs = (seq % nslots) * L3_ENTRY_SZ
+        (ntid, str_bytes) = struct.unpack_from(f'<i{L3_ENTRY_CONT_LEN}s', data, offs)
+        if ntid < 0:
+            # Skip continuation entries whose entry was overwritten.
+            if last == (seq - 1, ~ntid):
+                (key, (ring, tid, loc, msgptr, arg1, arg2)) = entry
+                if isinstance(arg2, int):
+                    arg2 = arg2.to_bytes(8, 'little')
+                entry = (key, (ring, tid, loc, msgptr, arg1, arg2 + str_bytes))
+                last = (seq, ~ntid)
+            continue
+        if msgids:
+            (tid, msgptr, tsc, arg1, arg2) = struct.unpack_from('<iIQQQ', data, offs)
+            loc = 0
+        else:
+            (tid, loc, msgptr, arg1, arg2) = struct.unpack_from('<iiQQQ', data, offs)
+            tsc = 0
+        # Skip slots that a concurrent writer has not yet filled-in.
+        if msgptr == 0:
+            continue
+        if entry is not None:
+            yield entry
+        entry = ((seq, 1, tsc),
+                 (L3_RING_DEFAULT_NAME, tid, loc, msgptr, arg1, arg2))
+        last = (seq, tid)
+    if entry is not None:
+        yield entry
+
+# #############################################################################
+def l3_unpack_rings(exts:list, channels:list = None, numa:bool = False) -> list:
+    """
+    Unpack the log-entries of the named rings, e.g. the "important" ring and
+    channels opened by l3_channel_open(), found in the extension records of
+    the L3-log file. If 'channels' is given, only rings of those names are
+    unpacked. If 'numa', i.e. L3_LOG_FLAG_NUMA, the rings of NUMA nodes are
+    also unpacked as the default ring. Each ring is laid out
+    as a L3_RING{} header followed by its slots of L3_XENTRY{}s:
+
+    typedef struct l3_ring
+    {
+        uint64_t        idx;
+        uint32_t        nslots;
+        uint32_t        pad0;
+        uint64_t        freeze_idx;
+        char            name[L3_RING_NAME_LEN];
+        L3_XENTRY       slots[];
+    } L3_RING;
+
+    typedef struct l3_xentry
+    {
+        pid_t       tid;
+        uint32_t    loc;
+        const char *msg;
+        uint64_t    arg1;
+        uint64_t    arg2;
+        uint64_t    tsc;
+        uint64_t    seq;
+    } L3_XENTRY;
+
+    Returns: List of iterators, one per ring, of its log-entries, oldest
+             first, in the form merged by l3_merge_rings().
+    """
+    rings = []
+    for (ext_type, payload) in exts:
+        if ext_type != L3_EXT_RING:
+            continue
+
+        (idx, nslots, name) = l3_unpack_ring_hdr(payload)
+        if channels is not None and name not in channels \
+           and not (L3_RING_DEFAULT_NAME in channels
+                    and l3_numa_node(name, numa) is not None):
+            continue
+        nslots = min(nslots, (len(payload) - L3_RING_HDR_SZ) // L3_XENTRY_SZ)
+        if nslots == 0:
+            continue
+        rings.append(l3_ring_entries(payload, name, idx, nslots))
+    return rings
+
+# #############################################################################
+def l3_ring_entries(payload, name:str, idx:int, nslots:int):
+    """
+    Unpack the log-entries of the named ring 'name', from its extension
+    record's 'payload', oldest first, as described by l3_unpack_rings().
+
+    Yields: Log-entries, in the form merged by l3_merge_rings().
+    """
+    for ring_idx in range(max(0, idx - nslots), idx):
+        offs = L3_RING_HDR_SZ + ((ring_idx % nslots) * L3_XENTRY_SZ)
+        (tid, loc, msgptr, arg1, arg2, tsc, seq) = struct.unpack_from('<iiQQQQQ',
+                                                                      payload, offs)
+        if msgptr == 0:
+            continue
+        yield ((seq, 0, tsc), (name, tid, loc, msgptr, arg1, arg2))
+
+# #############################################################################
+def l3_numa_node(ring:str, numa:bool):
+    """
+    Returns: The NUMA node of the ring named 'ring', if it is the ring of a
+             node, "numa<node>", of a L3-log file with L3_LOG_FLAG_NUMA, i.e.
+             'numa'. Otherwise, None.
+    """
+    node = ring[len(L3_RING_NUMA_PREFIX):]
+    if numa and ring.startswith(L3_RING_NUMA_PREFIX) and node.isdigit():
+        return int(node)
+    return None
+
+# #############################################################################
+def l3_unpack_modules(exts:list) -> list:
+    """
+    Unpack the map of modules loaded by the program, which is found in
+    crash-dump files written by the handlers installed by l3_init_crash_dump().
+    The extension record is an array of:
+
+    typedef struct l3_module
+    {
+        uint64_t    base;
+        char        path[L3_MODULE_PATH_LEN];
+    } L3_MODULE;
+
+    Returns: List of tuples: (load-address, module-path)
+    """
+    modules = []
+    for (ext_type, payload) in exts:
+        if ext_type != L3_EXT_MODULES:
+            continue
+        for offs in range(0, len(payload) - L3_MODULE_SZ + 1, L3_MODULE_SZ):
+            (base, path) = struct.unpack_from('<Q248s', payload, offs)
+            path = path.split(b'\0', 1)[0].decode(errors='ignore')
+            if path:
+                modules.append((base, path))
+    return modules
+
+# #############################################################################
+def l3_unpack_procs(exts:list) -> dict:
+    """
+    Unpack the table of processes attached to a log-file shared by
+    l3_init_shared(). The extension record is laid out as:
+
+    typedef struct l3_procs
+    {
+        uint32_t        nprocs;
+        uint32_t        pad0;
+        uint64_t        pad1;
+        L3_PROC         procs[L3_MAX_PROCS];
+    } L3_PROCS;
+
+    typedef struct l3_proc
+    {
+        pid_t           pid;
+        uint32_t        pad0;
+        uint64_t        fbase_addr;
+        char            path[L3_PROC_PATH_LEN];
+    } L3_PROC;
+
+    Returns: Dict: {slot: (pid, fbase_addr, binary-path)}, where slot # 'n'
+             is procs[n - 1]. Empty if the log-file is not shared.
+    """
+    procs = {}
+    for (ext_type, payload) in exts:
+        if ext_type != L3_EXT_PROCS:
+            continue
+        (nprocs, _, _) = struct.unpack_from('<IIQ', payload, 0)
+        nprocs = min(nprocs, (len(payload) - L3_PROCS_HDR_SZ) // L3_PROC_SZ)
+        for slot in range(1, nprocs + 1):
+            (pid, _, fbase_addr, path) \
+                = struct.unpack_from('<iIQ240s', payload,
+                                     L3_PROCS_HDR_SZ + (slot - 1) * L3_PROC_SZ)
+            path = path.split(b'\0', 1)[0].decode(errors='ignore')
+            procs[slot] = (pid, fbase_addr, path)
+    return procs
+
+# #############################################################################
+def l3_unpack_clock(exts:list) -> tuple:
+    """
+    Unpack the clock anchor recorded by l3_init(), which relates timestamps
+    of log-entries to wall-clock time. The extension record is laid out as:
+
+    typedef struct l3_clock
+    {
+        uint64_t        tsc;
+        uint64_t        realtime_ns;
+        uint64_t        tsc_per_sec;
+        uint64_t        pad0;
+    } L3_CLOCK;
+
+    Returns: Tuple of 3-ints: (tsc, realtime_ns, tsc_per_sec), or None for
+             log-files generated by older versions of L3.
+    """
+    for (ext_type, payload) in exts:
+        if ext_type != L3_EXT_CLOCK or len(payload) < L3_CLOCK_SZ:
+            continue
+        (tsc, realtime_ns, tsc_per_sec, _) = struct.unpack_from('<QQQQ', payload, 0)
+        if tsc_per_sec != 0:
+            return (tsc, realtime_ns, tsc_per_sec)
+    return None
+
+# #############################################################################
+def l3_unpack_strings(exts:list) -> dict:
+    """
+    Unpack the format strings of L3-logging call-sites, copied into the
+    log-file by l3_init(), which make the log-file self-describing. The
+    extension record is a sequence of L3_STRING{}s, each followed by the
+    NUL-terminated string:
+
+    typedef struct l3_string
+    {
+        uint64_t        addr;
+        uint32_t        size;
+        uint32_t        len;
+    } L3_STRING;
+
+    Returns: Dict: {msg-ptr: format-string}. Empty for log-files of
+             programs built by older versions of L3, or on Mac/OSX.
+    """
+    strings = {}
+    for (ext_type, payload) in exts:
+        if ext_type != L3_EXT_STRINGS:
+            continue
+        offs = 0
+        while offs + L3_STRING_HDR_SZ <= len(payload):
+            (addr, size, slen) = struct.unpack_from('<QII', payload, offs)
+            if size < L3_STRING_HDR_SZ + slen + 1:
+                break
+            start = offs + L3_STRING_HDR_SZ
+            strings[addr] = payload[start : start + slen].decode(errors='ignore')
+            offs += size
+    return strings
+
+# #############################################################################
+def l3_unpack_src_locs(exts:list) -> dict:
+    """
+    Unpack the L3_SRC_LOC{} descriptors of call-sites of the C++20 front end,
+    l3_log_srcloc(), copied into the log-file by l3_init(). The extension
+    record is a sequence of L3_SRC_LOC_REC{}s, each followed by the file name
+    and the function name, NUL-terminated:
+
+    typedef struct l3_src_loc_rec
+    {
+        uint64_t        addr;
+        uint32_t        size;
+        uint32_t        line;
+        uint32_t        column;
+        uint32_t        file_len;
+        uint32_t        func_len;
+        uint32_t        pad0;
+    } L3_SRC_LOC_REC;
+
+    Returns: Dict: {descriptor-addr: 'file:line:column function'}
+    """
+    src_locs = {}
+    for (ext_type, payload) in exts:
+        if ext_type != L3_EXT_SRC_LOCS:
+            continue
+        offs = 0
+        while offs + L3_SRC_LOC_REC_HDR_SZ <= len(payload):
+            (addr, size, line, column, file_len, func_len) \
+                = struct.unpack_from('<QIIIII', payload, offs)
+            if size < L3_SRC_LOC_REC_HDR_SZ + file_len + 1 + func_len + 1:
+                break
+            start = offs + L3_SRC_LOC_REC_HDR_SZ
+            file = payload[start : start + file_len].decode(errors='ignore')
+            start += file_len + 1
+            function = payload[start : start + func_len].decode(errors='ignore')
+            src_locs[addr] = f"{file}:{line}:{column} {function}"
+            offs += size
+    return src_locs
+
+# #############################################################################
+def l3_list_channels(idx:int, log_size:int, exts:list) -> list:
+    """
+    List the channels found in the L3-log file: The default ring, followed
+    by the named rings, in the order they were opened.
+
+    Returns: List of tuples: (channel-name, # of slots, # of entries logged)
+    """
+    channels = [(L3_RING_DEFAULT_NAME, log_size, idx)]
+    for (ext_type, payload) in exts:
+        if ext_type != L3_EXT_RING:
+            continue
+        (ring_idx, nslots, name) = l3_unpack_ring_hdr(payload)
+        channels.append((name, nslots, ring_idx))
+    return channels
+
+# #############################################################################
+def l3_merge_rings(*rings):
+    """
+    Merge log-entries unpacked from the default ring and from named rings
+    into one chronological sequence. Entries of the default ring are ordered
+    by their index. Entries of a named ring record the default ring's index
+    at the time they were logged, so they are placed just before the default
+    ring's entry at that index. Entries from different named rings, that
+    were logged at the same default ring index, are ordered by timestamp.
+
+    Each ring is unpacked oldest first, so is in this order already, but for
+    entries of concurrent writers, which are left in the order they claimed
+    their slots. The rings are merged lazily, holding only the next entry of
+    each ring.
+
+    Returns: Iterator of tuples: ((seq, default, tsc), log-entry), where
+             'default' is 1 for entries of the default ring, 'tsc' is 0 for
+             entries without a timestamp, and each log-entry is:
+             (ring-name, tid, loc, msgptr, arg1, arg2)
+    """
+    return heapq.merge(*rings, key=lambda entry: entry[0])
+
+# #############################################################################
+def l3_timeline(sorted_entries, clock:tuple):
+    """
+    Stamp the log-entries of an L3-log file, as merged by l3_merge_rings(),
+    with the wall-clock time they were logged at, using the file's clock
+    anchor. Entries of named rings carry a timestamp; those of the default
+    ring do so only under L3_LOG_FLAG_MSGID. Others are stamped with the time
+    of the preceding timestamped entry, or else of l3_init(). Times never
+    decrease, so the file's own order of entries is retained.
+
+    Yields: Tuples: (time-ns, log-entry)
+    """
+    if clock is None:
+        for (_, entry) in sorted_entries:
+            yield (0, entry)
+        return
+
+    (anchor_tsc, anchor_ns, tsc_per_sec) = clock
+    time_ns = anchor_ns
+    for ((_, _, tsc), entry) in sorted_entries:
+        if tsc != 0:
+            time_ns = max(time_ns,
+                          anchor_ns + ((tsc - anchor_tsc) * 1000000000) // tsc_per_sec)
+        yield (time_ns, entry)
+
+# #############################################################################
+def l3_tag_timeline(lognum:int, timeline):
+    """
+    Tag the time-stamped log-entries, yielded by l3_timeline(), with the #
+    of the L3-log file they were unpacked from.
+
+    Yields: Tuples: (time-ns, log #, log-entry)
+    """
+    for (time_ns, entry) in timeline:
+        yield (time_ns, lognum, entry)
+
+# #############################################################################
+def l3_merge_logs(timelines:list):
+    """
+    k-way merge of the time-stamped log-entries of several L3-log files, each
+    yielded by l3_timeline(), into one chronological stream. The entries of
+    each file are unpacked lazily from its rings, by l3_load_log(), so only
+    the next entry of each ring of each file is held, and entries are streamed
+    out as they are merged. Entries logged at the same time are ordered by the
+    # of their log-file.
+
+    Yields: Tuples: (time-ns, log #, log-entry)
+    """
+    tagged = [l3_tag_timeline(lognum, timeline)
+              for (lognum, timeline) in enumerate(timelines)]
+    return heapq.merge(*tagged, key=lambda item: item[:2])
+
+# #############################################################################
+def l3_warn_untimed(logs:list, consequence:str):
+    """
+    Warn, on stderr, of the log-files whose default ring's entries carry no
+    timestamps, as the program was not built with L3_MSGID_ENABLED=1. These
+    entries are stamped with the time of the preceding timestamped entry of
+    their log-file, or else of l3_init(), so they 'consequence'.
+    """
+    for log in logs:
+        if log['untimed']:
+            print(f"Warning: Entries of the default ring of {log['name']} have no"
+                  + f" timestamps, so they {consequence}. Build with"
+                  + " L3_MSGID_ENABLED=1 to timestamp them.", file=sys.stderr)
+
+# #############################################################################
+# Extraction of the L3-log image from core dumps: ELF64, little-endian, only.
+# #############################################################################
+ELF_PT_LOAD     = 1
+ELF_PT_NOTE     = 4
+ELF_SHT_SYMTAB  = 2
+ELF_SHT_RELA    = 4
+ELF_SHT_NOBITS  = 8
+ELF_STT_FUNC    = 2
+ELF_R_X86_64_RELATIVE = 8
+ELF_ET_DYN      = 3
+ELF_NT_AUXV     = 6
+ELF_AT_ENTRY    = 9
+
+# #############################################################################
+def elf_unpack_hdr(data, what:str) -> tuple:
+    """
+    Unpack the ELF64 header of an executable or core file.
+
+    Returns: Tuple: (e_type, e_entry, e_phoff, e_shoff, e_phnum, e_shnum)
+    """
+    if data[:4] != b'\x7fELF' or data[4] != 2 or data[5] != 1:
+        print(f"{what} is not a little-endian ELF64 file.")
+        sys.exit(1)
+
+    # pylint: disable-next=unused-variable
+    (e_type, _, _, e_entry, e_phoff, e_shoff, _, _, _, e_phnum, _, e_shnum, _) \
+        = struct.unpack_from('<HHIQQQIHHHHHH', data, 16)
+    return (e_type, e_entry, e_phoff, e_shoff, e_phnum, e_shnum)
+
+# #############################################################################
+def elf_symbols(data):
+    """
+    Iterate over the defined symbols in the symbol table, .symtab, of an
+    executable.
+
+    Yields: Tuple: (symbol-name, st_info, link-time address, size)
+    """
+    (_, _, _, e_shoff, _, e_shnum) = elf_unpack_hdr(data, 'Program binary')
+    for shctr in range(e_shnum):
+        # Elf64_Shdr{}: sh_name, sh_type, sh_flags, sh_addr, sh_offset,
+        #               sh_size, sh_link, sh_info, sh_addralign, sh_entsize
+        (_, sh_type, _, _, sh_offset, sh_size, sh_link, _, _, _) \
+            = struct.unpack_from('<IIQQQQIIQQ', data, e_shoff + shctr * 64)
+        if sh_type != ELF_SHT_SYMTAB:
+            continue
+
+        (_, _, _, _, str_offset, str_size, _, _, _, _) \
+            = struct.unpack_from('<IIQQQQIIQQ', data, e_shoff + sh_link * 64)
+        strtab = data[str_offset : str_offset + str_size]
+
+        # Elf64_Sym{}: st_name, st_info, st_other, st_shndx, st_value, st_size
+        for offs in range(sh_offset, sh_offset + sh_size, 24):
+            (st_name, st_info, _, st_shndx, st_value, st_size) \
+                = struct.unpack_from('<IBBHQQ', data, offs)
+            if st_shndx == 0:
+                continue
+            name = strtab[st_name : strtab.index(b'\0', st_name)].decode(errors='ignore')
+            yield (name, st_info, st_value, st_size)
+
+# #############################################################################
+def elf_find_symbols(data, names:list) -> dict:
+    """
+    Look up named symbols in the symbol table, .symtab, of an executable.
+
+    Returns: Dict: {symbol-name: link-time address}, of symbols found.
+    """
+    return { name: st_value
+             for (name, _, st_value, _) in elf_symbols(data) if name in names }
+
+# #############################################################################
+def elf_sections(data):
+    """
+    Iterate over the section headers of an executable.
+
+    Yields: Tuple: (sh_type, sh_addr, sh_offset, sh_size)
+    """
+    (_, _, _, e_shoff, _, e_shnum) = elf_unpack_hdr(data, 'Program binary')
+    for shctr in range(e_shnum):
+        (_, sh_type, _, sh_addr, sh_offset, sh_size, _, _, _, _) \
+            = struct.unpack_from('<IIQQQQIIQQ', data, e_shoff + shctr * 64)
+        yield (sh_type, sh_addr, sh_offset, sh_size)
+
+# #############################################################################
+def elf_read(data, addr:int, size:int) -> bytes:
+    """
+    Read 'size' bytes at link-time address 'addr' from the sections of an
+    executable. Returns None if 'addr' is not in the file.
+    """
+    for (sh_type, sh_addr, sh_offset, sh_size) in elf_sections(data):
+        if sh_type != ELF_SHT_NOBITS and sh_addr and sh_addr <= addr < sh_addr + sh_size:
+            offs = sh_offset + addr - sh_addr
+            return data[offs : offs + size]
+    return None
+
+# #############################################################################
+def elf_read_strings(data, addr:int, nptrs:int) -> list:
+    """
+    Read the strings pointed to by an array of 'nptrs' char pointers, at
+    link-time address 'addr', of an executable. The pointers of a PIE are
+    only filled-in by its R_X86_64_RELATIVE relocations.
+
+    Returns: List of strings, or None if some string is not found.
+    """
+    raw = elf_read(data, addr, nptrs * 8)
+    if raw is None or len(raw) != nptrs * 8:
+        return None
+    ptrs = list(struct.unpack(f"<{nptrs}Q", raw))
+    for (sh_type, _, sh_offset, sh_size) in elf_sections(data):
+        if sh_type != ELF_SHT_RELA:
+            continue
+        # Elf64_Rela{}: r_offset, r_info, r_addend
+        for offs in range(sh_offset, sh_offset + sh_size, 24):
+            (r_offset, r_info, r_addend) = struct.unpack_from('<QQq', data, offs)
+            if (addr <= r_offset < addr + nptrs * 8
+                    and (r_info & 0xffffffff) == ELF_R_X86_64_RELATIVE):
+                ptrs[(r_offset - addr) // 8] = r_addend
+
+    strings = []
+    for ptr in ptrs:
+        chunk = elf_read(data, ptr, PATH_MAX_BYTES) if ptr else None
+        if chunk is None or b'\0' not in chunk:
+            return None
+        strings.append(chunk[: chunk.index(b'\0')].decode(errors='ignore'))
+    return strings
+
+# #############################################################################
+def retaddr_symbolize(program_bin:str, fibase:int, loc:int,
+                      symbolizers:dict) -> str:
+    """
+    Symbolize the loc of a log-entry logged under L3_LOC_RETADDR, i.e., the
+    offset from the program's base-address of the return address into the
+    call-site, as 'function+offset file:line'. Uses the function symbols in
+    the binary's .symtab, and addr2line for its DWARF line-tables. The
+    symbols, and the locs symbolized, are cached per binary in 'symbolizers'.
+    """
+    real_bin = os.path.realpath(program_bin)
+    if real_bin not in symbolizers:
+        which_binary(OS_UNAME_S, 'addr2line')
+        with open(program_bin, 'rb') as file:
+            data = file.read()
+
+        # Non-PIE executables are loaded at their link-time addresses.
+        (e_type, _, _, _, _, _) = elf_unpack_hdr(data, 'Program binary')
+        bias = 0 if e_type == ELF_ET_DYN else fibase
+        funcs = sorted((st_value, st_size, name)
+                       for (name, st_info, st_value, st_size) in elf_symbols(data)
+                       if (st_info & 0xf) == ELF_STT_FUNC)
+        symbolizers[real_bin] = (bias, funcs, [func[0] for func in funcs], {})
+
+    (bias, funcs, func_addrs, locs) = symbolizers[real_bin]
+    if loc not in locs:
+        retaddr = loc + bias
+        func = '??'
+        fctr = bisect.bisect_right(func_addrs, retaddr - 1) - 1
+        if fctr >= 0:
+            (start, size, name) = funcs[fctr]
+            if retaddr - 1 < start + size:
+                func = f"{name}+0x{retaddr - start:x}"
+
+        # The line of the call-site is that of the call, preceding the
+        # return address.
+        line = exec_binary(['addr2line', '-e', program_bin, f"0x{retaddr - 1:x}"])
+        locs[loc] = f"{func} {line.split(' (discriminator')[0]}"
+    return locs[loc]
+
+# #############################################################################
+def core_unpack_segments(data) -> (list, int):
+    """
+    Unpack the PT_LOAD segments of a core file, which hold the memory image
+    of the crashed process, and find the run-time entry-point of the program
+    from the auxiliary vector, in the PT_NOTE segment.
+
+    Returns: Tuple: (list of (vaddr, file-offset, file-size), entry-point)
+    """
+    (_, _, e_phoff, _, e_phnum, _) = elf_unpack_hdr(data, 'Core file')
+    segments = []
+    at_entry = None
+    for phctr in range(e_phnum):
+        # Elf64_Phdr{}: p_type, p_flags, p_offset, p_vaddr, p_paddr,
+        #               p_filesz, p_memsz, p_align
+        (p_type, _, p_offset, p_vaddr, _, p_filesz, _, _) \
+            = struct.unpack_from('<IIQQQQQQ', data, e_phoff + phctr * 56)
+        if p_type == ELF_PT_LOAD:
+            segments.append((p_vaddr, p_offset, p_filesz))
+
+        elif p_type == ELF_PT_NOTE:
+            offs = p_offset
+            while offs + 12 <= p_offset + p_filesz:
+                (namesz, descsz, n_type) = struct.unpack_from('<III', data, offs)
+                desc = offs + 12 + ((namesz + 3) & ~3)
+                if n_type == ELF_NT_AUXV:
+                    for auxv in range(desc, desc + descsz, 16):
+                        (a_type, a_val) = struct.unpack_from('<QQ', data, auxv)
+                        if a_type == ELF_AT_ENTRY:
+                            at_entry = a_val
+                offs = desc + ((descsz + 3) & ~3)
+    return (segments, at_entry)
+
+# #############################################################################
+def core_read(data, segments:list, addr:int, size:int) -> bytes:
+    """
+    Read 'size' bytes at virtual address 'addr' of the crashed process.
+    Error out if the memory was not dumped to the core file.
+    """
+    for (vaddr, offset, filesz) in segments:
+        if vaddr <= addr and addr + size <= vaddr + filesz:
+            return data[offset + addr - vaddr : offset + addr - vaddr + size]
+
+    print(f"Memory at 0x{addr:x}, {size} bytes, is not found in the core file."
+          + " File-backed shared mappings are dumped only if bit 3 of"
+          + " /proc/<pid>/coredump_filter is set.")
+    sys.exit(1)
+
+# #############################################################################
+def l3_core_extract(core_file:str, program_bin:str) -> bytes:
+    """
+    Extract the image of the L3-log file from the core file of a program that
+    crashed, logging to an in-memory, or file-backed, ring. The global
+    l3_log_ring points to the mapped L3_LOG{}, which is followed by its
+    extension records. Named channels, mapped separately, are found via the
+    table of channels, l3_channels[]. The image is laid out as a L3-log file.
+
+    Returns: Bytes of the L3-log file's image.
+    """
+    with open(program_bin, 'rb') as file:
+        prog = file.read()
+    (e_type, e_entry, _, _, _, _) = elf_unpack_hdr(prog, 'Program binary')
+    symbols = elf_find_symbols(prog, ['l3_log_ring', 'l3_ext_base_end_offs',
+                                      'l3_channels', 'l3_nchannels'])
+    if 'l3_log_ring' not in symbols or 'l3_ext_base_end_offs' not in symbols:
+        print(f"L3 symbols are not found in the symbol table of {program_bin}.")
+        sys.exit(1)
+
+    with open(core_file, 'rb') as file, \
+         mmap.mmap(file.fileno(), 0, access=mmap.ACCESS_READ) as core:
+
+        (segments, at_entry) = core_unpack_segments(core)
+
+        # Position-independent executables are loaded at a random base.
+        load_bias = 0
+        if e_type == ELF_ET_DYN and at_entry is not None:
+            load_bias = at_entry - e_entry
+
+        def read_u64(addr:int) -> int:
+            return struct.unpack('<Q', core_read(core, segments, addr, 8))[0]
+
+        l3_log = read_u64(load_bias + symbols['l3_log_ring'])
+        if l3_log == 0:
+            print(f"L3-logging was not initialized by the crashed {program_bin}.")
+            sys.exit(1)
+        base_end_offs = read_u64(load_bias + symbols['l3_ext_base_end_offs'])
+        image = [core_read(core, segments, l3_log, base_end_offs)]
+
+        # Append the extension records of named channels mapped separately.
+        if 'l3_channels' in symbols and 'l3_nchannels' in symbols:
+            nchannels = read_u64(load_bias + symbols['l3_nchannels']) & 0xffffffff
+            for cctr in range(nchannels):
+                (ring, _, maplen, _) = struct.unpack('<QQQQ',
+                        core_read(core, segments,
+                                  load_bias + symbols['l3_channels']
+                                  + cctr * L3_CHANNEL_MAP_SZ,
+                                  L3_CHANNEL_MAP_SZ))
+                if maplen == 0:
+                    continue
+                ext = ring - L3_EXT_HDR_SZ
+                (_, _, size) = struct.unpack('<IIQ',
+                                             core_read(core, segments, ext, L3_EXT_HDR_SZ))
+                image.append(core_read(core, segments, ext, L3_EXT_HDR_SZ + size))
+
+    image.append(struct.pack('<IIQ', L3_EXT_END, 0, 0))
+    return b''.join(image)
+
+# #############################################################################
+def sample_policy_str(policy:int, k:int, n:int) -> str:
+    """
+    Describe the sampling policy of a sampled call-site.
+    """
+    if policy == L3_SAMPLE_EVERY_N:
+        return f"sampled 1-in-{n}"
+    if policy == L3_SAMPLE_FIRST_K:
+        return f"sampled first-{k}-then-1-in-{n}"
+    if policy == L3_SAMPLE_MAX_RATE:
+        return f"rate-limited max-{n}/sec"
+    return ""
+
+# #############################################################################
+def sample_extrapolate(policy:int, k:int, n:int, nlogged:int) -> int:
+    """
+    Extrapolate the # of times a sampled call-site was executed, given the
+    # of log-entries it logged. Counts are per-thread for sampled sites, so
+    this is an estimate. Rate-limited sites cannot be extrapolated; return
+    the # of log-entries as-is.
+    """
+    if policy == L3_SAMPLE_EVERY_N:
+        return nlogged * n
+    if policy == L3_SAMPLE_FIRST_K:
+        return nlogged if nlogged <= k else k + ((nlogged - k) * n)
+    return nlogged
+
+# #############################################################################
+def select_loc_decoder_bin(decode_loc_id:int, program_bin:str,
+                           loc_decoder_bin:str):
+    """
+    Based on the type of LOC-encoding scheme found in the log-header, i.e.,
+    decode_loc_id, and the input program binary's name, figure out which
+    LOC-decoder binary to be used while unpacking LOC-ID values that may be
+    encoded in log-entries.
+
+    Currently, we only support decoding LOC-IDs encoded by default LOC scheme.
+     - Search for a LOC-decoder binary specified by the --loc-binary argument.
+     - Otherwiwse, search for a default LOC-binary named "<program_binary>_loc".
+    """
+    loc_decoder = None
+    if decode_loc_id == L3_LOC_DEFAULT:
+        loc_decoder = loc_decoder_bin
+        if loc_decoder is None and program_bin is not None:
+            loc_decoder = program_bin + "_loc"
+        if loc_decoder is None or os.path.exists(loc_decoder) is False:
+            print(f"L3-log file uses default L3_LOC_ENCODING={decode_loc_id} "
+                  +  " encoding scheme, but the required "
+                  + f"LOC-decoder binary {loc_decoder} is not found.")
+            sys.exit(1)
+
+    return loc_decoder
+
+# #############################################################################
+# The default LOC-encoding packs, in a LOC-ID, the index of the source file
+# in the LOC-generated loc_filenames[] table and the line number.
+LOC_FILENAMES_SYMBOL    = 'loc_filenames'
+LOC_FILE_INDEX_SHIFT    = 16
+LOC_LINE_MASK           = 0xffff
+
+# Max length of file names read from loc_filenames[]
+PATH_MAX_BYTES          = 4096
+
+# #############################################################################
+def loc_filenames_load(loc_decoder_bin:str) -> list:
+    """
+    Read the LOC-generated table of source file names, loc_filenames[],
+    from the .symtab and data of the LOC-decoder binary.
+
+    Returns: List of file names, indexed by file-index, or None if not found.
+    """
+    with open(loc_decoder_bin, 'rb') as file:
+        data = file.read()
+    if data[:4] != b'\x7fELF':
+        return None
+
+    for (name, _, st_value, st_size) in elf_symbols(data):
+        if name == LOC_FILENAMES_SYMBOL and st_size:
+            return elf_read_strings(data, st_value, st_size // 8)
+    return None
+
+# #############################################################################
+def loc_decode(loc_decoders:dict, loc_decoder_bin:str, loc:int) -> str:
+    """
+    Unpack a LOC-ID, encoded by the default LOC-encoding scheme, to its
+    'file:line' string. Rather than exec the LOC-decoder binary for each
+    new LOC-ID, look it up in the decoder binary's loc_filenames[] table,
+    which is read once. The 1st LOC-ID so decoded is cross-checked against
+    the LOC-decoder binary, which is used for all LOC-IDs if they disagree,
+    or if the table is not found. LOC-IDs decoded are cached per decoder
+    binary in 'loc_decoders'.
+    """
+    if loc_decoder_bin not in loc_decoders:
+        loc_decoders[loc_decoder_bin] = { 'filenames': loc_filenames_load(loc_decoder_bin),
+                                          'verified' : False,
+                                          'locs'     : {} }
+    decoder = loc_decoders[loc_decoder_bin]
+    locs = decoder['locs']
+    if loc in locs:
+        return locs[loc]
+
+    unpacked = None
+    filenames = decoder['filenames']
+    file_idx = loc >> LOC_FILE_INDEX_SHIFT
+    if filenames is not None and file_idx < len(filenames):
+        unpacked = f"{filenames[file_idx]}:{loc & LOC_LINE_MASK}"
+
+        if not decoder['verified']:
+            decoded = exec_binary([loc_decoder_bin, '--brief', str(loc)])
+            if decoded != unpacked:
+                print(f"LOC-ID {loc} decodes to '{decoded}', not '{unpacked}'"
+                      + f" as by loc_filenames[] of {loc_decoder_bin}.")
+                decoder['filenames'] = None
+                unpacked = decoded
+            decoder['verified'] = True
+
+    if unpacked is None:
+        unpacked = exec_binary([loc_decoder_bin, '--brief', str(loc)])
+    locs[loc] = unpacked
+    return unpacked
+
+# #############################################################################
+def exec_binary(cmdargs:list) -> str:
+    """Execute a binary, with args, and print output to stdout."""
+    try:
+        with subprocess.Popen(cmdargs, stdout=subprocess.PIPE, text=True) as output:
+            sp_stdout, sp_stderr = output.communicate()
+
+    except subprocess.CalledProcessError as exc:
+        print(f"sp.run() Status: FAIL, rc={exc.returncode}"
+              + "\nstderrr={stderr} \nargs={exc.args}"
+              + "\nstdout={exc.stdout}"
+              + "\nstderr={exc.stderr}")
+
+    if sp_stderr is None:
+        return sp_stdout.strip('\n')
+    return sp_stdout + " " + sp_stderr
+
+# #############################################################################
+def mac_get__cstring_offset(program_bin:str) -> int:
+    """
+    Helper method to crack-open binary being examined on Mac/OSX and to extract
+    out the 'offset' at which 'Section __cstring' starts.
+
+    This data should really be extracted from within the program binary, like
+    it's done on Liux, as part of l3_init(). But somehow the Mach-O interface
+    for locating that offset is not very evident.
+
+    For now, do this round-about thing to decode using `size` utility available
+    on Mac/OSX.
+
+     $ xcrun size -x -l -m <program_bin>
+
+    And post-process stdout from that looking for a line like:
+
+        Section __cstring: 0x1f3 (addr 0x100003dc4 offset 15812)
+
+    ... to extract out the last number '15812'
+    """
+
+    assert OS_UNAME_S == 'Darwin'
+
+    # -----------------------------------------------------------------------
+    # NOTE: We really would like to do this field extraction in one cmd as:
+    # pylint: disable-next=line-too-long
+    #   xcrun size -x -l -m <program-bin> | grep __cstring | cut -f2 -d'(' | awk '{print $NF}' | cut -f1 -d')'
+    #
+    # But for some reason, splitting this long grep-cmd into args and
+    # pumping it through exec_binary() is never working.
+    # For now, resort to a simpler command and post-process downstream.
+    # -----------------------------------------------------------------------
+
+    grep_cmd = r'''xcrun size -x -l -m ''' + program_bin
+
+    cmdargs = shlex.split(grep_cmd)
+    _stdout = exec_binary(cmdargs)
+
+    # -----------------------------------------------------------------------
+    # Construct a r.e. to match a line in the output like:
+    #   Section __cstring: 0x1f3 (addr 0x100003dc4 offset 15812)
+    #
+    # We want to extract '15812' out of 'offset 15812)'
+    # -----------------------------------------------------------------------
+    offset = -1
+    cstring_re_pat = re.compile(r'(.*)__cstring:(.*)(\s+)offset(\s+)(?P<offset_int>(\d+))\)')
+    for line in _stdout.split('\n'):
+        # DEBUG: print(line)
+        line_match = cstring_re_pat.match(line)
+        if line_match is None:
+            continue
+
+        offset = int(line_match.group('offset_int'))
+
+    # DEBUG: print(f"{offset=}")
+    assert offset != -1
+    return offset
+
+###############################################################################
+def typed_args(arg_types:tuple, arg1:int, arg2:int) -> tuple:
+    """
+    Decode the raw bits of the arguments logged by a call-site of the C++20
+    front end, l3::log<>(), or of l3_log_str(), by the types in its
+    L3_ARG_TYPES{} descriptor.
+
+    Returns: Tuple of the decoded arguments, one per argument logged.
+    """
+    args = []
+    for (arg_type, arg) in zip(arg_types, (arg1, arg2)):
+        if arg_type == L3_ARG_NONE:
+            break
+        if arg_type == L3_ARG_STR:
+            args.append(str_arg(arg1, arg2))
+            break
+        if arg_type == L3_ARG_INT and arg >= (1 << 63):
+            arg -= (1 << 64)
+        elif arg_type == L3_ARG_DOUBLE:
+            arg = struct.unpack('<d', struct.pack('<Q', arg))[0]
+        elif arg_type == L3_ARG_CHAR:
+            arg &= 0xff
+        args.append(arg)
+    return tuple(args)
+
+###############################################################################
+def str_arg(nbytes:int, str_bytes) -> str:
+    """
+    Decode the string logged by a call-site of l3_log_str(): 'nbytes' of it,
+    from the 'str_bytes' gathered from its entry and continuation entries,
+    else from the entry's arg2 alone, if the string fit in it.
+    """
+    if isinstance(str_bytes, int):
+        str_bytes = str_bytes.to_bytes(8, 'little')
+    return str_bytes[:nbytes].split(b'\0')[0].decode(errors='replace')
+
+###############################################################################
+def bytes_arg(nbytes:int, data) -> (int, bytes):
+    """
+    Split the 'data' gathered from the entry and continuation entries logged
+    by l3_log_bytes() into the pointer to its tag, logged as arg2, and the
+    'nbytes' of the buffer.
+    """
+    if isinstance(data, int):
+        data = data.to_bytes(8, 'little')
+    return (int.from_bytes(data[:8], 'little'), data[8 : 8 + nbytes])
+
+# Decoders of buffers logged by l3_log_bytes(), by their tag. See --decoders.
+L3_BLOB_DECODERS = {}
+
+###############################################################################
+def register_blob_decoder(tag:str, decoder) -> None:
+    """
+    Register 'decoder', a callable taking the bytes of a buffer and returning
+    its description, for the buffers logged by l3_log_bytes() with 'tag'.
+    """
+    L3_BLOB_DECODERS[tag] = decoder
+
+###############################################################################
+def l3_load_decoders(path:str) -> None:
+    """
+    Load a decoder plugin, a Python file that defines L3_DECODERS, a dict:
+    {tag: decoder}, and register its decoders. See register_blob_decoder().
+    """
+    name = os.path.splitext(os.path.basename(path))[0]
+    spec = importlib.util.spec_from_file_location(name, path)
+    if spec is None:
+        sys.exit(f"Cannot load decoders from '{path}'.")
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    for (tag, decoder) in getattr(module, 'L3_DECODERS', {}).items():
+        register_blob_decoder(tag, decoder)
+
+###############################################################################
+def blob_hexdump(blob:bytes) -> str:
+    """
+    Default decoder of buffers logged by l3_log_bytes(): Their hexdump.
+    """
+    return ' '.join(f"{byte:02x}" for byte in blob)
+
+###############################################################################
+def blob_decode(tag:str, blob:bytes) -> str:
+    """
+    Decode a buffer logged by l3_log_bytes() with 'tag', by the decoder
+    registered for the tag, else by its hexdump. The hexdump is also the
+    fall-back should the decoder fail, e.g. on a buffer truncated to
+    L3_LOG_BYTES_MAX bytes.
+    """
+    decoder = L3_BLOB_DECODERS.get(tag)
+    if decoder is not None:
+        try:
+            return decoder(blob)
+        except Exception:   # pylint: disable=broad-except
+            pass
+    return f"{tag}[{len(blob)}]: {blob_hexdump(blob)}"
+
+###############################################################################
+def do_c_print(msg_text:str, arg1:int, arg2:int) -> str:
+    """
+    Parse an input C-style format-string to convert it to a form that is
+    accepted by Python. Invoke C-style printing using provided arguments.
+    If there is any exception in printing, fall-back to just dumping the
+    input arguments, without any modifications.
+
+    Returns: The C-format msg-string replaced with arguments
+    """
+    format_string = fmtstr_replace(msg_text)
+    # DEBUG: print(f"{format_string=}")
+    msg_text = format_string % (arg1, arg2)
+    return msg_text
+
+###############################################################################
+@functools.lru_cache(maxsize=None)
+def fmtstr_replace(fmtstr:str) -> str:
+    """
+    Perform couple of in-place format-specifier replacement to a form that
+    is supported by Python's print() method.
+    For now, do two simple subsitutions, in order, of:
+        - '0x%p' in format string with '0x%x'
+        - '%p' in format string with '0x%x'
+        - Replace all specifiers for unsigned-int with plain '%d'
+    """
+    format_string = fmtstr.replace('0x%p', '0x%x', 2)
+    format_string = format_string.replace('%p', '0x%x', 2)
+    format_string = format_string.replace('%u', '%d', 2)
+    format_string = format_string.replace('%lu', '%d', 2)
+    format_string = format_string.replace('%llu', '%d', 2)
+    return format_string
+
+# #############################################################################
+# Annotations of the arguments of format strings, decoded by the dumper:
+#   %d{enum:<type>} : Name of the enumerator, of the enum or typedef <type>,
+#                     found in the DWARF of the binary.
+#   %d{errno}       : Name of the errno, e.g. ENOENT.
+# printf() ignores them, printing the annotation after the integer.
+# #############################################################################
+FMT_CONV_RE = re.compile(r'%(?:%|[-+ #0]*(?:\d+|\*)?(?:\.(?:\d+|\*))?'
+                         + r'(?:hh|h|ll|l|j|z|t|L)?(?P<conv>[diouxXeEfgGcsp])'
+                         + r'(?:\{(?P<annot>errno|enum:\w+)\})?)')
+
+###############################################################################
+@functools.lru_cache(maxsize=None)
+def fmtstr_annotations(fmtstr:str) -> (str, tuple):
+    """
+    Parse the annotations of the arguments of a format string.
+
+    Returns: Tuple: (format string, with its annotated conversions replaced
+             by '%s', tuple of the annotation of each argument, else None).
+             The tuple is empty if no argument is annotated.
+    """
+    annots = []
+    def conv_replace(match):
+        if match.group(0) == '%%':
+            return '%%'
+        annots.append(match.group('annot'))
+        return '%s' if match.group('annot') else match.group(0)
+
+    format_string = FMT_CONV_RE.sub(conv_replace, fmtstr)
+    if not any(annots):
+        return (fmtstr, ())
+    return (format_string, tuple(annots))
+
+###############################################################################
+def annotated_arg(annot:str, arg:int, enum_types:dict) -> str:
+    """
+    Decode an argument by its annotation, into the name of its enumerator
+    or of its errno. Values without a name are printed as integers.
+    """
+    if arg >= (1 << 63):
+        arg -= (1 << 64)
+    if annot == 'errno':
+        name = errno.errorcode.get(arg)
+    else:
+        name = enum_types.get(annot[len('enum:'):], {}).get(arg)
+    return name if name is not None else str(arg)
+
+###############################################################################
+def annotated_args(annots:tuple, arg1:int, arg2:int,
+                   program_bin:str, dwarf_enums:dict) -> tuple:
+    """
+    Decode the arguments by their annotations, parsed by fmtstr_annotations().
+    The enums of 'program_bin' are parsed from its DWARF, and cached in
+    'dwarf_enums', only if an argument is annotated by an enum type.
+
+    Returns: Tuple of the arguments, annotated ones as names.
+    """
+    enum_types = {}
+    if program_bin and any(annot.startswith('enum:') for annot in annots if annot):
+        enum_types = l3_binary_enums(program_bin, dwarf_enums)
+
+    return tuple(annotated_arg(annot, arg, enum_types) if annot else arg
+                 for (annot, arg) in zip(annots, (arg1, arg2)))
+
+###############################################################################
+def do_annotated_print(msg_fmt:str, arg1:int, arg2:int,
+                       program_bin:str, dwarf_enums:dict) -> str:
+    """
+    As do_c_print(), decoding the arguments annotated in the format string.
+    """
+    (format_string, annots) = fmtstr_annotations(msg_fmt)
+    if not annots:
+        return do_c_print(msg_fmt, arg1, arg2)
+
+    return fmtstr_replace(format_string) % annotated_args(annots, arg1, arg2,
+                                                          program_bin,
+                                                          dwarf_enums)
+
+# #############################################################################
+DWARF_DIE_RE = re.compile(r'^\s*<(?P<depth>\d+)><(?P<offset>[0-9a-f]+)>:'
+                          + r' Abbrev Number: \d+ \((?P<tag>DW_TAG_\w+)\)')
+DWARF_ATTR_RE = re.compile(r'^\s*<[0-9a-f]+>\s+(?P<attr>DW_AT_\w+)\s*:\s*(?P<value>.*)$')
+
+###############################################################################
+def parse_dwarf_enums(input_str:str) -> dict:
+    """
+    Parse the output of `readelf --debug-dump=info` to extract the enums,
+    by the names of their types, and of the typedefs of them. E.g.:
+
+ <1><359>: Abbrev Number: 43 (DW_TAG_enumeration_type)
+    <35a>   DW_AT_name        : (indirect string, offset: 0xe407): test_l3_state
+ <2><36a>: Abbrev Number: 5 (DW_TAG_enumerator)
+    <36b>   DW_AT_name        : (indirect string, offset: 0x389a): TEST_L3_IDLE
+    <36f>   DW_AT_const_value : 0
+ <1><383>: Abbrev Number: 7 (DW_TAG_typedef)
+    <384>   DW_AT_name        : (indirect string, offset: 0x74ed): test_l3_state_t
+    <38b>   DW_AT_type        : <0x359>
+
+    Returns: Dictionary: {type-name: {value: enumerator-name}}
+    """
+    enums = {}          # offset of enum: {value: enumerator-name}
+    names = {}          # offset of enum or typedef: (type-name, type-offset)
+    die = None
+    enum = None
+    for line in input_str.splitlines():
+        die_match = DWARF_DIE_RE.match(line)
+        if die_match:
+            depth = int(die_match.group('depth'))
+            offset = int(die_match.group('offset'), 16)
+            tag = die_match.group('tag')
+            if enum is not None and depth <= enum[0]:
+                enum = None
+            if tag == 'DW_TAG_enumeration_type':
+                enum = (depth, offset)
+                enums[offset] = {}
+            die = [tag, offset, None, None, None]
+            continue
+
+        attr_match = DWARF_ATTR_RE.match(line)
+        if not die or not attr_match:
+            continue
+
+        (attr, value) = (attr_match.group('attr'), attr_match.group('value'))
+        if attr == 'DW_AT_name':
+            die[2] = value.rsplit(': ', 1)[-1].strip()
+        elif attr == 'DW_AT_type':
+            die[3] = int(value.strip('<> '), 16)
+        elif attr == 'DW_AT_const_value':
+            die[4] = int(value.split()[0], 0)
+        else:
+            continue
+
+        (tag, offset, name, type_offset, const_value) = die
+        if tag == 'DW_TAG_enumerator' and enum is not None \
+                and name is not None and const_value is not None:
+            enums[enum[1]].setdefault(const_value, name)
+        elif tag in ('DW_TAG_enumeration_type', 'DW_TAG_typedef') and name:
+            names[offset] = (name, type_offset if tag == 'DW_TAG_typedef' else offset)
+
+    # Resolve typedefs, also of typedefs, to their enums.
+    enum_types = {}
+    for (name, type_offset) in names.values():
+        for _ in range(8):
+            if type_offset in enums or type_offset not in names:
+                break
+            type_offset = names[type_offset][1]
+        if type_offset in enums:
+            enum_types.setdefault(name, {}).update(enums[type_offset])
+    return enum_types
+
+# #############################################################################
+def l3_binary_enums(program_bin:str, dwarf_enums:dict) -> dict:
+    """
+    Parse the enums of a program binary from its DWARF, caching the results
+    by the binary's real path. See parse_dwarf_enums().
+    """
+    real_bin = os.path.realpath(program_bin)
+    if real_bin not in dwarf_enums:
+        which_binary(OS_UNAME_S, READELF_BIN)
+        with subprocess.Popen([READELF_BIN, '--debug-dump=info', program_bin],
+                              stdout=subprocess.PIPE,
+                              stderr=subprocess.PIPE, text=True) as dump:
+            _stdout, _stderr = dump.communicate()
+        dwarf_enums[real_bin] = parse_dwarf_enums(_stdout)
+    return dwarf_enums[real_bin]
+
+# #############################################################################
+# Export of log-entries as Chrome JSON trace-events, which are loaded by the
+# Perfetto UI (https://ui.perfetto.dev) and by chrome://tracing.
+# #############################################################################
+TRACE_SPAN_RE = re.compile(r'^\s*(begin|end)\b[\s:,-]*(.*)$', re.IGNORECASE)
+
+# #############################################################################
+@functools.lru_cache(maxsize=None)
+def trace_span_phase(fmtstr:str) -> (str, str):
+    """
+    Classify a message format-string as beginning or ending a duration slice,
+    when its 1st word is 'Begin' or 'End', as in "Begin request id=%d" and
+    "End request id=%d". The slice is named by the rest of the format-string,
+    so the pair is recognized however the arguments vary.
 
-    Returns: Tuple of 3-ints: (fibase, l3_platform, decode_loc_id)
+    Returns: Tuple: (trace-event phase, name): 'B', 'E' or 'i' (instant).
     """
-    data = file_hdl.read(L3_LOG_HEADER_SZ)
+    match = TRACE_SPAN_RE.match(fmtstr)
+    if match is None or not match.group(2):
+        return ('i', fmtstr)
+    return ('B' if match.group(1).lower() == 'begin' else 'E', match.group(2))
 
-    # '<' => byte-order of the header is little-endian
-    # See: https://docs.python.org/3/library/struct.html
-    # pylint: disable-next=unused-variable
-    (_, fibase, pad0, pad2, l3_platform, loc_type, pad1) = struct.unpack('<QQihBBQ', data)
+# #############################################################################
+def trace_open(trace_file:str) -> dict:
+    """
+    Start streaming trace-events to the JSON trace-file.
 
-    # Interpret LOC-encoding scheme flag as loc-encoding type-ID
-    if loc_type == L3_LOG_LOC_ENCODING:
-        decode_loc_id = L3_LOC_DEFAULT
-    elif loc_type == L3_LOG_LOC_ELF_ENCODING:
-        decode_loc_id = L3_LOC_ELF_ENCODING
-    else:
-        decode_loc_id = L3_LOC_UNSET
+    Returns: Dictionary of the state of the trace-file being written.
+    """
+    # pylint: disable-next=consider-using-with
+    file = open(trace_file, 'w', encoding='utf-8')
+    file.write('{"displayTimeUnit":"ns","traceEvents":[\n')
+    return { 'file': file, 'nevents': 0, 'time0': None, 'pids': set(),
+             'track_ns': {} }
 
-    # DEBUG: print(f"{l3_platform=}, {decode_loc_id=}")
-    return (fibase, l3_platform, decode_loc_id)
+# #############################################################################
+def trace_write_event(trace:dict, event:dict):
+    """
+    Append a trace-event to the JSON trace-file.
+    """
+    trace['file'].write((',\n' if trace['nevents'] else '')
+                        + json.dumps(event, separators=(',', ':')))
+    trace['nevents'] += 1
 
+# #############################################################################
+# pylint: disable-next=too-many-arguments
+def trace_log_entry(trace:dict, time_ns:int, pid:int, process:str, tid:int,
+                    fmtstr:str, msg_text:str, args:dict):
+    """
+    Write a log-entry as a trace-event on the track of its thread: A slice
+    begins, or ends, for messages classified so by trace_span_phase(). Other
+    messages are instant events. Times are relative to the 1st log-entry.
+    Entries without a timestamp of their own, which share the time of the
+    preceding entry, are spaced 1 ns apart on their track, to be visible.
+    """
+    if trace['time0'] is None:
+        trace['time0'] = time_ns
+    if pid not in trace['pids']:
+        trace['pids'].add(pid)
+        trace_write_event(trace, { 'name': 'process_name', 'ph': 'M',
+                                   'pid': pid, 'args': { 'name': process } })
+
+    track = (pid, tid)
+    track_ns = max(time_ns - trace['time0'], trace['track_ns'].get(track, -1) + 1)
+    trace['track_ns'][track] = track_ns
+
+    (phase, name) = trace_span_phase(fmtstr)
+    event = { 'name': msg_text if phase == 'i' else name, 'ph': phase,
+              'ts': track_ns / 1000,
+              'pid': pid, 'tid': tid, 'args': args }
+    if phase == 'i':
+        event['s'] = 't'
+    else:
+        args['msg'] = msg_text
+    trace_write_event(trace, event)
 
 # #############################################################################
-def select_loc_decoder_bin(decode_loc_id:int, program_bin:str,
-                           loc_decoder_bin:str):
+def trace_close(trace:dict):
     """
-    Based on the type of LOC-encoding scheme found in the log-header, i.e.,
-    decode_loc_id, and the input program binary's name, figure out which
-    LOC-decoder binary to be used while unpacking LOC-ID values that may be
-    encoded in log-entries.
+    Finish the JSON trace-file.
+    """
+    trace['file'].write('\n]}\n')
+    trace['file'].close()
 
-    Currently, we only support decoding LOC-IDs encoded by default LOC scheme.
-     - Search for a LOC-decoder binary specified by the --loc-binary argument.
-     - Otherwiwse, search for a default LOC-binary named "<program_binary>_loc".
+# #############################################################################
+# Export of log-entries as a CTF 1.8 (Common Trace Format) trace, which is
+# loaded by Trace Compass and by babeltrace. The trace is a directory with a
+# 'metadata' file, describing each message as an event class, and a binary
+# stream of packets of events, written out as log-entries are unpacked.
+# All fields are byte-aligned, and little-endian.
+# #############################################################################
+CTF_MAGIC               = 0xc1fc1fc1
+CTF_STREAM_FILE         = 'stream_0'
+CTF_PACKET_SIZE         = 256 * 1024    # Bytes of events, per packet
+
+# Packet header: magic, uuid[16], stream_id. Packet context:
+# timestamp_begin, timestamp_end, content_size, packet_size, in bits.
+CTF_PACKET_HDR          = struct.Struct('<I16sI')
+CTF_PACKET_CTX          = struct.Struct('<QQQQ')
+
+# Event header: id, timestamp. Event context: _vpid, _vtid.
+CTF_EVENT_HDR           = struct.Struct('<IQii')
+
+# Types of the fields of event classes: (TSDL type, struct-format)
+CTF_TYPES = { 'int64'   : ('int64_t', 'q'),
+              'uint64'  : ('uint64_t', 'Q'),
+              'hex64'   : ('uint64x_t', 'Q'),
+              'double'  : ('double', 'd'),
+              'string'  : ('string', None) }
+
+CTF_ARG_TYPES = { L3_ARG_INT    : 'int64',
+                  L3_ARG_UINT   : 'uint64',
+                  L3_ARG_DOUBLE : 'double',
+                  L3_ARG_PTR    : 'hex64',
+                  L3_ARG_CHAR   : 'uint64',
+                  L3_ARG_STR    : 'string',
+                  L3_ARG_BYTES  : 'string' }
+
+CTF_CONV_TYPES = { 'd': 'int64', 'i': 'int64',
+                   'x': 'hex64', 'X': 'hex64', 'p': 'hex64',
+                   'e': 'double', 'E': 'double', 'f': 'double',
+                   'g': 'double', 'G': 'double',
+                   's': 'string' }
+
+CTF_METADATA_HDR = """/* CTF 1.8 */
+
+typealias integer { size = 32; align = 8; signed = false; } := uint32_t;
+typealias integer { size = 32; align = 8; signed = true; } := int32_t;
+typealias integer { size = 8; align = 8; signed = false; } := uint8_t;
+typealias integer { size = 64; align = 8; signed = false; } := uint64_t;
+typealias integer { size = 64; align = 8; signed = true; } := int64_t;
+typealias integer { size = 64; align = 8; signed = false; base = 16; } := uint64x_t;
+typealias floating_point { exp_dig = 11; mant_dig = 53; align = 8; } := double;
+
+trace {
+    major = 1;
+    minor = 8;
+    uuid = "%s";
+    byte_order = le;
+    packet.header := struct {
+        uint32_t magic;
+        uint8_t  uuid[16];
+        uint32_t stream_id;
+    };
+};
+
+env {
+    tracer_name = "l3";
+};
+
+clock {
+    name = l3_clock;
+    description = "Wall-clock time of L3 log-entries, in ns since the Epoch";
+    freq = 1000000000;
+    offset = 0;
+};
+
+typealias integer {
+    size = 64; align = 8; signed = false;
+    map = clock.l3_clock.value;
+} := uint64_clock_t;
+
+stream {
+    id = 0;
+    packet.context := struct {
+        uint64_clock_t timestamp_begin;
+        uint64_clock_t timestamp_end;
+        uint64_t content_size;
+        uint64_t packet_size;
+    };
+    event.header := struct {
+        uint32_t id;
+        uint64_clock_t timestamp;
+    };
+    event.context := struct {
+        int32_t _vpid;
+        int32_t _vtid;
+    };
+};
+"""
+
+# #############################################################################
+def ctf_open(ctf_dir:str) -> dict:
     """
-    loc_decoder = None
-    if decode_loc_id == L3_LOC_DEFAULT:
-        loc_decoder = program_bin + "_loc" if loc_decoder_bin is None else loc_decoder_bin
-        if os.path.exists(loc_decoder) is False:
-            print(f"L3-log file uses default L3_LOC_ENCODING={decode_loc_id} "
-                  +  " encoding scheme, but the required "
-                  + f"LOC-decoder binary {loc_decoder} is not found.")
-            sys.exit(1)
+    Start streaming events into the stream of the CTF trace in 'ctf_dir'.
 
-    return loc_decoder
+    Returns: Dictionary of the state of the CTF trace being written.
+    """
+    os.makedirs(ctf_dir, exist_ok=True)
+    # pylint: disable-next=consider-using-with
+    file = open(os.path.join(ctf_dir, CTF_STREAM_FILE), 'wb')
+    return { 'dir': ctf_dir, 'file': file, 'uuid': uuid.uuid4(),
+             'classes': {}, 'packet': bytearray(), 'time_begin': None,
+             'time_end': 0, 'nevents': 0 }
 
 # #############################################################################
-def exec_binary(cmdargs:list) -> str:
-    """Execute a binary, with args, and print output to stdout."""
-    try:
-        with subprocess.Popen(cmdargs, stdout=subprocess.PIPE, text=True) as output:
-            sp_stdout, sp_stderr = output.communicate()
+@functools.lru_cache(maxsize=None)
+def ctf_conv_types(msg_fmt:str) -> tuple:
+    """
+    Types of the fields of the event class of an untyped call-site, by the
+    conversions of its format string. Annotated arguments are names.
+    """
+    types = []
+    for match in FMT_CONV_RE.finditer(msg_fmt):
+        if match.group(0) == '%%':
+            continue
+        if match.group('annot'):
+            types.append('string')
+        else:
+            types.append(CTF_CONV_TYPES.get(match.group('conv'), 'uint64'))
+    return tuple(types[:2])
 
-    except subprocess.CalledProcessError as exc:
-        print(f"sp.run() Status: FAIL, rc={exc.returncode}"
-              + "\nstderrr={stderr} \nargs={exc.args}"
-              + "\nstdout={exc.stdout}"
-              + "\nstderr={exc.stderr}")
+# #############################################################################
+def ctf_event_args(msg_fmt:str, site_types:tuple, arg1:int, arg2,
+                   program_bin:str, dwarf_enums:dict) -> (tuple, tuple):
+    """
+    Decode the arguments of a log-entry into the fields of its event class:
+    By the types described by its call-site, else by its format string.
 
-    if sp_stderr is None:
-        return sp_stdout.strip('\n')
-    return sp_stdout + " " + sp_stderr
+    Returns: Tuple: (types of the fields, values of the fields)
+    """
+    if isinstance(arg2, str):
+        return (('string',), (arg2,))
+
+    if site_types:
+        values = typed_args(site_types, arg1, arg2)
+        return (tuple(CTF_ARG_TYPES.get(arg_type, 'uint64')
+                      for arg_type in site_types[:len(values)]), values)
+
+    types = ctf_conv_types(msg_fmt)
+    (_, annots) = fmtstr_annotations(msg_fmt)
+    if annots:
+        values = annotated_args(annots, arg1, arg2, program_bin, dwarf_enums)
+    else:
+        values = (arg1, arg2)
+    values = tuple(value - (1 << 64) if (ftype == 'int64' and value >= (1 << 63))
+                   else value
+                   for (ftype, value) in zip(types, values))
+    return (types, values)
 
 # #############################################################################
-def mac_get__cstring_offset(program_bin:str) -> int:
+def ctf_event_class(ctf:dict, msg_fmt:str, types:tuple) -> tuple:
     """
-    Helper method to crack-open binary being examined on Mac/OSX and to extract
-    out the 'offset' at which 'Section __cstring' starts.
+    Look up, else define, the event class of a message with fields of
+    'types'.
 
-    This data should really be extracted from within the program binary, like
-    it's done on Liux, as part of l3_init(). But somehow the Mach-O interface
-    for locating that offset is not very evident.
+    Returns: Tuple: (id, struct packing the numeric fields, or None)
+    """
+    key = (msg_fmt, types)
+    if key not in ctf['classes']:
+        packer = None
+        if 'string' not in types:
+            packer = struct.Struct('<' + ''.join(CTF_TYPES[ftype][1] for ftype in types))
+        ctf['classes'][key] = (len(ctf['classes']), packer)
+    return ctf['classes'][key]
 
-    For now, do this round-about thing to decode using `size` utility available
-    on Mac/OSX.
+# #############################################################################
+# pylint: disable-next=too-many-arguments
+def ctf_log_entry(ctf:dict, time_ns:int, pid:int, tid:int, msg_fmt:str,
+                  types:tuple, values:tuple):
+    """
+    Append a log-entry, as an event of its message's event class, to the
+    packet being filled, which is written out once it is full.
+    """
+    (class_id, packer) = ctf_event_class(ctf, msg_fmt, types)
+    packet = ctf['packet']
+    packet += CTF_EVENT_HDR.pack(class_id, time_ns, pid, tid)
+    if packer is not None:
+        packet += packer.pack(*values)
+    else:
+        for (ftype, value) in zip(types, values):
+            if ftype == 'string':
+                packet += str(value).encode(errors='replace').replace(b'\0', b'') + b'\0'
+            else:
+                packet += struct.pack('<' + CTF_TYPES[ftype][1], value)
 
-     $ xcrun size -x -l -m <program_bin>
+    if ctf['time_begin'] is None:
+        ctf['time_begin'] = time_ns
+    ctf['time_end'] = time_ns
+    ctf['nevents'] += 1
+    if len(packet) >= CTF_PACKET_SIZE:
+        ctf_flush_packet(ctf)
 
-    And post-process stdout from that looking for a line like:
+# #############################################################################
+def ctf_flush_packet(ctf:dict):
+    """
+    Write out the events of the packet being filled, as a packet, preceded
+    by its header and its context.
+    """
+    packet = ctf['packet']
+    if not packet:
+        return
+    nbits = (CTF_PACKET_HDR.size + CTF_PACKET_CTX.size + len(packet)) * 8
+    ctf['file'].write(CTF_PACKET_HDR.pack(CTF_MAGIC, ctf['uuid'].bytes, 0))
+    ctf['file'].write(CTF_PACKET_CTX.pack(ctf['time_begin'], ctf['time_end'],
+                                          nbits, nbits))
+    ctf['file'].write(packet)
+    ctf['packet'] = bytearray()
+    ctf['time_begin'] = None
 
-        Section __cstring: 0x1f3 (addr 0x100003dc4 offset 15812)
+# #############################################################################
+def ctf_tsdl_string(string:str) -> str:
+    """
+    Quote a string, e.g. a format string, as a TSDL string literal.
+    """
+    escapes = { '\\': '\\\\', '"': '\\"', '\n': '\\n', '\t': '\\t', '\r': '\\r' }
+    return '"' + ''.join(escapes.get(char, char if char.isprintable()
+                                     else f"\\x{ord(char):02x}")
+                         for char in string) + '"'
 
-    ... to extract out the last number '15812'
+# #############################################################################
+def ctf_metadata(ctf:dict) -> str:
     """
+    Generate the TSDL metadata of the trace: Its stream, and the event class
+    of each message, named by its format string, whose fields are the
+    arguments logged, arg1 and arg2.
+    """
+    metadata = [CTF_METADATA_HDR % ctf['uuid']]
+    for ((msg_fmt, types), (class_id, _)) in ctf['classes'].items():
+        fields = ''.join(f"\n        {CTF_TYPES[ftype][0]} arg{fctr + 1};"
+                         for (fctr, ftype) in enumerate(types))
+        metadata.append(f"""
+event {{
+    name = {ctf_tsdl_string(msg_fmt)};
+    id = {class_id};
+    stream_id = 0;
+    fields := struct {{{fields}
+    }};
+}};
+""")
+    return ''.join(metadata)
 
-    assert OS_UNAME_S == 'Darwin'
+# #############################################################################
+def ctf_close(ctf:dict):
+    """
+    Finish the CTF trace: Write out the last packet, and the metadata, once
+    all event classes are known.
+    """
+    ctf_flush_packet(ctf)
+    ctf['file'].close()
+    with open(os.path.join(ctf['dir'], 'metadata'), 'w', encoding='utf-8') as file:
+        file.write(ctf_metadata(ctf))
 
-    # -----------------------------------------------------------------------
-    # NOTE: We really would like to do this field extraction in one cmd as:
-    # pylint: disable-next=line-too-long
-    #   xcrun size -x -l -m <program-bin> | grep __cstring | cut -f2 -d'(' | awk '{print $NF}' | cut -f1 -d')'
-    #
-    # But for some reason, splitting this long grep-cmd into args and
-    # pumping it through exec_binary() is never working.
-    # For now, resort to a simpler command and post-process downstream.
-    # -----------------------------------------------------------------------
+# #############################################################################
+# Analysis of duration spans logged by l3_span_begin() / l3_span_end(), whose
+# message format-strings are synthesized by L3_SPAN_{BEGIN,END}_MSG().
+# #############################################################################
+SPAN_MSG_RE = re.compile(r'^(Begin|End) (.+): span=%l{0,2}u, tsc=%l{0,2}u$')
 
-    grep_cmd = r'''xcrun size -x -l -m ''' + program_bin
+# #############################################################################
+@functools.lru_cache(maxsize=None)
+def span_msg_parse(fmtstr:str) -> tuple:
+    """
+    Identify the format-string of a log-entry as beginning, or ending, a span.
 
-    cmdargs = shlex.split(grep_cmd)
-    _stdout = exec_binary(cmdargs)
+    Returns: Tuple: (is-begin, span-name), or None for other log-entries.
+    """
+    match = SPAN_MSG_RE.match(fmtstr)
+    if match is None:
+        return None
+    return (match.group(1) == 'Begin', match.group(2))
 
-    # -----------------------------------------------------------------------
-    # Construct a r.e. to match a line in the output like:
-    #   Section __cstring: 0x1f3 (addr 0x100003dc4 offset 15812)
-    #
-    # We want to extract '15812' out of 'offset 15812)'
-    # -----------------------------------------------------------------------
-    offset = -1
-    cstring_re_pat = re.compile(r'(.*)__cstring:(.*)(\s+)offset(\s+)(?P<offset_int>(\d+))\)')
-    for line in _stdout.split('\n'):
-        # DEBUG: print(line)
-        line_match = cstring_re_pat.match(line)
-        if line_match is None:
-            continue
+# #############################################################################
+def span_percentile(durations:list, pct:float) -> int:
+    """
+    Nearest-rank percentile of a sorted, non-empty, list of durations.
+    """
+    rank = max(1, -(-len(durations) * pct // 100))
+    return durations[int(rank) - 1]
 
-        offset = int(line_match.group('offset_int'))
+# #############################################################################
+def span_duration_str(duration:int, unit:str) -> str:
+    """
+    Format a span's duration: In micro-seconds, or in timestamp-counter ticks
+    for log-files without a clock anchor.
+    """
+    if unit == 'ns':
+        return f"{duration / 1000:.3f} us"
+    return f"{duration} ticks"
 
-    # DEBUG: print(f"{offset=}")
-    assert offset != -1
-    return offset
+# #############################################################################
+def span_report(spans:dict, open_spans:dict, unmatched_ends:list):
+    """
+    Report latency percentiles, and a histogram of durations in power-of-2
+    buckets, for each span name. Report spans whose begin is not found in
+    the ring, e.g. as it was overwritten, and spans that have not ended.
 
-###############################################################################
-def do_c_print(msg_text:str, arg1:int, arg2:int) -> str:
+    Arguments:
+        spans           - Dict: {(span-name, unit): [durations]}
+        open_spans      - Dict: {(log #, pid, tid, span-id): (span-name, tsc)}
+        unmatched_ends  - List of tuples: (span-name, tid, span-id)
     """
-    Parse an input C-style format-string to convert it to a form that is
-    accepted by Python. Invoke C-style printing using provided arguments.
-    If there is any exception in printing, fall-back to just dumping the
-    input arguments, without any modifications.
+    for ((name, unit), durations) in sorted(spans.items()):
+        durations.sort()
+        pctls = ', '.join(f"{label}={span_duration_str(span_percentile(durations, pct), unit)}"
+                          for (label, pct) in (('p50', 50), ('p99', 99), ('p999', 99.9)))
+        print(f"Span '{name}': {len(durations)} spans, {pctls},"
+              + f" max={span_duration_str(durations[-1], unit)}")
+
+        buckets = {}
+        for duration in durations:
+            bucket = duration.bit_length()
+            buckets[bucket] = buckets.get(bucket, 0) + 1
+        for (bucket, nspans) in sorted(buckets.items()):
+            print(f"    < {span_duration_str(1 << bucket, unit):>16}: {nspans}")
+
+    for ((_, _, tid, span), (name, _)) in open_spans.items():
+        print(f"Unmatched span '{name}': not ended, {tid=}, {span=}")
+    for (name, tid, span) in unmatched_ends:
+        print(f"Unmatched span '{name}': begin not found, {tid=}, {span=}")
 
-    Returns: The C-format msg-string replaced with arguments
+# #############################################################################
+def cpu_migrated(last_cpus:dict, key:tuple, cpu:int):
     """
-    format_string = fmtstr_replace(msg_text)
-    # DEBUG: print(f"{format_string=}")
-    msg_text = format_string % (arg1, arg2)
-    return msg_text
+    Track the CPU of consecutive log-entries of each thread, identified by
+    'key', of logs built with L3_CPUID_ENABLED.
 
-###############################################################################
-def fmtstr_replace(fmtstr:str) -> str:
+    Entries of tid 0 are not tracked, as log-files of versions of L3 that
+    cached only the tid of the thread that initialized L3-logging, log tid 0
+    from all other threads.
+
+    Returns: The CPU of the thread's previous log-entry, if the thread has
+             migrated from it to 'cpu' since. Otherwise, None.
     """
-    Perform couple of in-place format-specifier replacement to a form that
-    is supported by Python's print() method.
-    For now, do two simple subsitutions, in order, of:
-        - '0x%p' in format string with '0x%x'
-        - '%p' in format string with '0x%x'
-        - Replace all specifiers for unsigned-int with plain '%d'
+    if key[-1] == 0:
+        return None
+    prev_cpu = last_cpus.get(key)
+    last_cpus[key] = cpu
+    if prev_cpu is None or prev_cpu == cpu:
+        return None
+    return prev_cpu
+
+# #############################################################################
+def cpu_report(per_cpu:dict, migrations:dict):
     """
-    format_string = fmtstr.replace('0x%p', '0x%x', 2)
-    format_string = format_string.replace('%p', '0x%x', 2)
-    format_string = format_string.replace('%u', '%d', 2)
-    format_string = format_string.replace('%lu', '%d', 2)
-    format_string = format_string.replace('%llu', '%d', 2)
-    return format_string
+    Print the timeline of log-entries of each CPU, if requested by --per-cpu,
+    and the # of migrations between CPUs of each thread that migrated.
+
+    Arguments:
+        per_cpu     - Dict: {cpu: [printed log-entries]}, or None
+        migrations  - Dict: {(log #, pid, tid): # of migrations}
+    """
+    for (cpu, lines) in sorted((per_cpu or {}).items()):
+        print(f"CPU {cpu}: {len(lines)} log-entries")
+        for line in lines:
+            print(f"    {line}")
+
+    for ((_, _, tid), nmigrations) in sorted(migrations.items()):
+        print(f"Thread {tid=}: {nmigrations} migrations between CPUs.")
 
 ###############################################################################
 # main() driver
@@ -416,6 +2170,123 @@ def main():
     """
     do_main(sys.argv[1:])
 
+# #############################################################################
+def l3_binary_strings(program_bin:str, binary_strings:dict) -> tuple:
+    """
+    Parse the message-strings of a program binary, and the offsets needed
+    to locate them, caching the results by the binary's real path.
+
+    Returns: Tuple: (rodata-offset, strings-dictionary, cstring-offset)
+    """
+    if program_bin is None:
+        sys.exit("Log-file does not have the format strings of all log-entries."
+                 + " Specify the program binary with --binary.")
+
+    real_bin = os.path.realpath(program_bin)
+    if real_bin not in binary_strings:
+        # Validate that required binary used below are found in $PATH.
+        which_binary(OS_UNAME_S, READELF_BIN)
+
+        rodata_offs = parse_rodata_start_addr(program_bin)
+        strings = parse_rodata_string_offsets(program_bin)
+        cstring_off = 0
+        if OS_UNAME_S == 'Darwin':
+            cstring_off = mac_get__cstring_offset(program_bin)
+            # DEBUG: print(strings)
+        binary_strings[real_bin] = (rodata_offs, strings, cstring_off)
+    return binary_strings[real_bin]
+
+# #############################################################################
+def l3_msg_string(msgptr:int, fmt_strings:dict, msg_bin:str, msg_fibase:int,
+                  binary_strings:dict) -> str:
+    """
+    Look up the literal string logged at 'msgptr', e.g. the format string of
+    a log-entry, in the strings copied into the log-file, else in the binary
+    that logged it, loaded at 'msg_fibase'.
+    """
+    msg_fmt = fmt_strings.get(msgptr)
+    if msg_fmt is None:
+        (msg_rodata_offs, msg_strings, cstring_off) \
+            = l3_binary_strings(msg_bin, binary_strings)
+
+        # print(f"{msgptr=}, {msg_fibase=}, {msg_rodata_offs=}")
+
+        if OS_UNAME_S == 'Linux':
+            offs = msgptr - msg_fibase - msg_rodata_offs
+
+        elif OS_UNAME_S == 'Darwin':
+            offs = msgptr - msg_fibase - cstring_off
+
+        else:
+            offs = 0
+
+        # print(f"{msgptr=:x}, {msg_fibase=:x}, {msg_rodata_offs=:x}, {offs=}")
+        msg_fmt = msg_strings[offs]
+    return msg_fmt
+
+# #############################################################################
+def l3_load_log(l3_logfile:str, core_file:str, program_bin:str,
+                channels:list) -> dict:
+    """
+    Unpack the header, extension records and log-entries of an L3-log file,
+    or of its image extracted from a core file, generated by 'program_bin'.
+
+    Returns: Dictionary describing the L3-log, with an iterator of its
+             log-entries, as merged by l3_merge_rings(). These are unpacked
+             as they are iterated, from a read-only mapping of the log-file,
+             which is unmapped once they are all unpacked.
+    """
+    if core_file:
+        file = io.BytesIO(l3_core_extract(core_file, program_bin))
+    else:
+        with open(l3_logfile, 'rb') as logfile:
+            file = mmap.mmap(logfile.fileno(), 0, access=mmap.ACCESS_READ)
+
+    # Unpack the 1st n-bytes as an L3_LOG{} struct to get a hold
+    # of the fbase-address stashed by the l3_init() call.
+    (fibase, _, decode_loc_id) = l3_unpack_loghdr(file)
+
+    # Unpack extension records describing the log-entries.
+    flags = l3_unpack_logflags(file)
+    msgids = bool(flags & L3_LOG_FLAG_MSGID)
+    numa = bool(flags & L3_LOG_FLAG_NUMA)
+    (idx, log_size) = l3_unpack_logsize(file)
+    exts = l3_unpack_exts(file, log_size)
+
+    # Merge log-entries from all rings, or from named channels, oldest first.
+    rings = l3_unpack_rings(exts, channels, numa)
+    untimed = False
+    if channels is None or L3_RING_DEFAULT_NAME in channels:
+        rings.insert(0, l3_unpack_default_ring(file, idx, log_size, msgids))
+        untimed = (idx > 0) and not msgids
+    entries = l3_merge_rings(*rings)
+
+    return { 'name'         : os.path.basename(l3_logfile or core_file),
+             'program_bin'  : program_bin,
+             # Format strings copied into the log-file, if any. Otherwise,
+             # the strings of the program binary are parsed when needed.
+             'fmt_strings'  : l3_unpack_strings(exts),
+             'fibase'       : fibase,
+             # Entries of the default ring log message ids, not msg pointers.
+             'msgids'       : msgids,
+             # Threads logged to the rings of their NUMA nodes.
+             'numa'         : numa,
+             'decode_loc_id': decode_loc_id,
+             'channels'     : l3_list_channels(idx, log_size, exts),
+             'modules'      : l3_unpack_modules(exts),
+             'sample_sites' : l3_unpack_sample_sites(exts),
+             'arg_types'    : l3_unpack_arg_types(exts),
+             # Call-sites of l3_log_srcloc() log offsets of these, as loc.
+             'src_locs'     : l3_unpack_src_locs(exts),
+             'sample_counts': {},
+             # Processes sharing the log-file may have logged from other
+             # binaries, whose strings are parsed when their 1st entry is found.
+             'procs'        : l3_unpack_procs(exts),
+             'clock'        : l3_unpack_clock(exts),
+             # Entries of the default ring are unpacked without timestamps.
+             'untimed'      : untimed,
+             'entries'      : entries }
+
 ###############################################################################
 # pylint: disable-msg=too-many-statements
 # pylint: disable-msg=too-many-branches
@@ -426,9 +2297,12 @@ def do_main(args:list, return_logentry_lists:bool = False):
     it can be called independently via pytests.
 
     Arguments:
-        args[0] - Str: Name of L3-log file
+        args[0] - Str: Name of L3-log file, or of core file (--core-file)
         args[1] - Str: Name of binary that generated L3-log file.
 
+    Several L3-log files, each with the binary that generated it, are merged
+    into one chronological sequence of log-entries.
+
     Returns: A collection of output things:
         - # entries processed
         - Individual lists for fields unpacked from set of log-entries processed.
@@ -438,19 +2312,21 @@ def do_main(args:list, return_logentry_lists:bool = False):
     # Parse command-line arguments into script locals
     parsed_args = l3_parse_args(args)
 
-    l3_logfile  = parsed_args.log_file
-    program_bin = parsed_args.prog_binary
+    core_file   = parsed_args.core_file
     loc_decoder_bin = parsed_args.loc_binary
-
-    # Validate that required binary used below are found in $PATH.
-    which_binary(OS_UNAME_S, READELF_BIN)
-
-    rodata_offs = parse_rodata_start_addr(program_bin)
-
-    strings = parse_rodata_string_offsets(program_bin)
-    if OS_UNAME_S == 'Darwin':
-        cstring_off = mac_get__cstring_offset(program_bin)
-        # DEBUG: print(strings)
+    channels    = parsed_args.channels
+
+    # Pair each L3-log file with the binary that generated it. One binary
+    # may be named for all log-files.
+    log_files   = parsed_args.log_file if parsed_args.log_file else [None]
+    prog_bins   = parsed_args.prog_binary or [None]
+    if core_file and prog_bins[0] is None:
+        sys.exit("Specify the program binary, that crashed, with --binary.")
+    if len(prog_bins) == 1:
+        prog_bins = prog_bins * len(log_files)
+    elif len(prog_bins) != len(log_files):
+        sys.exit(f"Expected 1 --binary argument, or {len(log_files)},"
+                 + " one per --log-file argument.")
 
     # To enable unit-testing, via pytests, the parsing and return-data logic
     # build lists for the data as it's being cracked open.
@@ -460,102 +2336,284 @@ def do_main(args:list, return_logentry_lists:bool = False):
     arg1_list = []
     arg2_list = []
 
-    with open(l3_logfile, 'rb') as file:
-        # Unpack the 1st n-bytes as an L3_LOG{} struct to get a hold
-        # of the fbase-address stashed by the l3_init() call.
-        (fibase, _, decode_loc_id) = l3_unpack_loghdr(file)
-
-        loc_decoder_bin = select_loc_decoder_bin(decode_loc_id,
-                                                 program_bin,
-                                                 loc_decoder_bin)
-        # pylint: disable=invalid-name
-        nentries = 0
-        loc_prev = 0
-        # Keep reading chunks of log-entries from file ...
-        while True:
-            row = file.read(L3_ENTRY_SZ)
-            len_row = len(row)
-
-            # Deal with eof
-            if not row or len_row == 0 or len_row < L3_ENTRY_SZ:
-                break
-
-            tid, loc, msgptr, arg1, arg2 = struct.unpack('<iiQQQ', row)
-
-            # If no entry was logged, ptr to message's string is expected to be NULL
-            if msgptr == 0:
-                break
-
-            # print(f"{msgptr=}, {fibase=}, {rodata_offs=}")
-
-            if OS_UNAME_S == 'Linux':
-                offs = msgptr - fibase - rodata_offs
-
-            elif OS_UNAME_S == 'Darwin':
-                offs = msgptr - fibase - cstring_off
-
-            else:
-                offs = 0
-
-            # print(f"{msgptr=:x}, {fibase=:x}, {rodata_offs=:x}, {offs=}")
-
-            # Generate C-style sprintf() output on message-string.
-            msg_text = do_c_print(strings[offs], arg1, arg2)
-
-            # No location-ID will be recorded in log-files if L3_LOC_ENABLED is OFF.
-            UNPACK_LOC = ''
-            if loc == 0:
-
-                # ----------------------------------------------------------------
-                # We found a 0 LOC-ID but as per the L3-log header, some
-                # LOC-encoding scheme was in effect. So, it's sort-off odd
-                # to find a 0 LOC-ID. Report it, to tag investigation.
-                if decode_loc_id != L3_LOC_UNSET:
-                    print(f"{tid=} {loc=} '{msg_text}'")
-                else:
-                    print(f"{tid=} '{msg_text}'")
-
-            elif decode_loc_id == L3_LOC_UNSET:
-
-                # ----------------------------------------------------------------
-                # This is a potential error somewhere, that no LOC-encoding scheme
-                # was in-effect in the build, but we found a non-zero LOC-ID!
-                print(f"{tid=} {loc=} '{msg_text}'")
-
-            elif decode_loc_id == L3_LOC_DEFAULT:
-                # ----------------------------------------------------------------
-                # Minor optimization to speed-up unpacking of L3 log-dumps from
-                # tests that log millions of log-entries from the same line-of-code.
-                # If we found a new location-ID, unpack it.
-                if loc != loc_prev:
-                    UNPACK_LOC = exec_binary([loc_decoder_bin, '--brief', str(loc)])
-
-                    # Save-off location-ID and unpacked string for next loop
-                    unpack_loc_prev = UNPACK_LOC
-                    loc_prev = loc
+    # Unpack the log-files, or the image extracted from a core file.
+    logs = []
+    binary_strings = {}
+    dwarf_enums = {}
+    symbolizers = {}
+    for (l3_logfile, program_bin) in zip(log_files, prog_bins):
+        log = l3_load_log(l3_logfile, core_file, program_bin, channels)
+        logs.append(log)
+
+        for (base, path) in log['modules']:
+            print(f"Module '{path}' loaded at 0x{base:x}")
+
+        if parsed_args.list_channels:
+            for (name, nslots, nlogged) in log['channels']:
+                print(f"Channel '{name}': {nslots} slots, {nlogged} log-entries.")
+
+        log['loc_decoder_bin'] = select_loc_decoder_bin(log['decode_loc_id'],
+                                                        program_bin,
+                                                        loc_decoder_bin)
+    if parsed_args.list_channels:
+        return (0, tid_list, loc_list, msg_list, arg1_list, arg2_list)
+
+    # Merge log-entries of several log-files by the time logged.
+    timelines = [l3_timeline(log['entries'], log['clock']) for log in logs]
+    if len(logs) == 1:
+        entries = l3_tag_timeline(0, timelines[0])
+    else:
+        l3_warn_untimed(logs, "are not interleaved with other log-files")
+        entries = l3_merge_logs(timelines)
+
+    # Decoders of buffers logged by l3_log_bytes(), from plugins.
+    for decoders in parsed_args.decoders or []:
+        l3_load_decoders(decoders)
+
+    # Export log-entries as trace-events, instead of printing them.
+    trace = None
+    if parsed_args.trace_file:
+        l3_warn_untimed(logs, "are spaced 1 ns apart in the trace, and durations"
+                              + " of slices between them are not meaningful")
+        trace = trace_open(parsed_args.trace_file)
+
+    # Export log-entries as a CTF trace, instead of printing them.
+    ctf = None
+    if parsed_args.ctf_dir:
+        l3_warn_untimed(logs, "are spaced 1 ns apart in the trace")
+        ctf = ctf_open(parsed_args.ctf_dir)
+
+    # Pair the begin / end entries of spans, instead of printing them.
+    spans = {} if parsed_args.spans else None
+    open_spans = {}
+    unmatched_ends = []
+
+    # Group log-entries by the CPU logged, under L3_CPUID_ENABLED, and
+    # detect threads migrating between CPUs across their log-entries.
+    per_cpu = {} if parsed_args.per_cpu else None
+    last_cpus = {}
+    migrations = {}
+
+    # pylint: disable=invalid-name
+    nentries = 0
+    loc_decoders = {}
+    for (time_ns, lognum, (ring, tid, loc, msgptr, arg1, arg2)) in entries:
+
+        log = logs[lognum]
+        decode_loc_id = log['decode_loc_id']
+        sample_sites = log['sample_sites']
+        sample_counts = log['sample_counts']
+        procs = log['procs']
+        pid = lognum
+
+        # Tag log-entries from rings other than the default ring.
+        RING = '' if ring == L3_RING_DEFAULT_NAME else f" {ring=}"
+
+        # Tag log-entries from rings of NUMA nodes with their node, instead.
+        node = l3_numa_node(ring, log['numa'])
+        if node is not None:
+            RING = f" {node=}"
+
+        # Decode msg pointers logged by a process sharing the log-file
+        # against its own binary, loaded at its own base-address.
+        msg_fibase = log['fibase']
+        msg_bin = log['program_bin']
+        fmt_strings = log['fmt_strings']
+        arg_types = log['arg_types']
+        src_locs = log['src_locs']
+        if procs:
+            slot = tid >> L3_PROC_SLOT_SHIFT
+            tid &= ((1 << L3_PROC_SLOT_SHIFT) - 1)
+            if slot in procs:
+                (pid, msg_fibase, proc_bin) = procs[slot]
+                RING = f" {pid=}" + RING
+                msg_bin = proc_bin or log['program_bin']
+
+                # The log-file has the format strings of its creator only.
+                if slot != L3_PROC_SLOT_CREATOR:
+                    fmt_strings = {}
+                    arg_types = {}
+                    src_locs = {}
+
+        # Message ids are offsets of msg from the base-address of the binary.
+        if log['msgids'] and ring == L3_RING_DEFAULT_NAME:
+            msgptr += msg_fibase
+
+        # Tag log-entries merged from several log-files with their log-file.
+        if len(logs) > 1:
+            RING = f" log='{log['name']}'" + RING
+
+        # Look up the format string in the log-file, else in the binary.
+        msg_fmt = l3_msg_string(msgptr, fmt_strings, msg_bin, msg_fibase,
+                                binary_strings)
+
+        # Decode the string logged by l3_log_str(), or the buffer logged by
+        # l3_log_bytes(), which is reported as the entry's arg2. Strings
+        # logged by a process whose descriptors are not in the log-file are
+        # still found, by their continuation entries.
+        site_types = arg_types.get(msgptr, ())
+        if L3_ARG_BYTES in site_types:
+            (tagptr, blob) = bytes_arg(arg1, arg2)
+            tag = l3_msg_string(tagptr, fmt_strings, msg_bin, msg_fibase,
+                                binary_strings)
+            arg2 = blob_decode(tag, blob)
+        elif L3_ARG_STR in site_types or isinstance(arg2, bytes):
+            arg2 = str_arg(arg1, arg2)
+
+        # Generate C-style sprintf() output on message-string, decoding the
+        # arguments by their types, if the call-site describes them.
+        if isinstance(arg2, str):
+            msg_text = fmtstr_replace(msg_fmt) % (arg2,)
+        elif msgptr in arg_types:
+            msg_text = fmtstr_replace(msg_fmt) % typed_args(arg_types[msgptr],
+                                                             arg1, arg2)
+        else:
+            msg_text = do_annotated_print(msg_fmt, arg1, arg2, msg_bin,
+                                          dwarf_enums)
+
+        # Tag entries logged by sampled call-sites with the sampling ratio.
+        SAMPLED = ''
+        if msgptr in sample_sites:
+            SAMPLED = ' [' + sample_policy_str(*sample_sites[msgptr]) + ']'
+            (nlogged, _) = sample_counts.get(msgptr, (0, msg_fmt))
+            sample_counts[msgptr] = (nlogged + 1, msg_fmt)
+
+        # No location-ID will be recorded in log-files if L3_LOC_ENABLED is OFF.
+        UNPACK_LOC = ''
+        LOC = ''
+        if decode_loc_id == L3_LOC_CPUID:
+
+            # ----------------------------------------------------------------
+            # The loc is the CPU # that the entry was logged on. Tag the
+            # entries of a thread that migrated since its previous entry.
+            UNPACK_LOC = f"cpu={loc}"
+            LOC = f" {UNPACK_LOC}"
+            prev_cpu = cpu_migrated(last_cpus, (lognum, pid, tid), loc)
+            if prev_cpu is not None:
+                LOC += f" [migrated from cpu={prev_cpu}]"
+                migrations[(lognum, pid, tid)] \
+                    = migrations.get((lognum, pid, tid), 0) + 1
+
+        elif loc == 0:
+
+            # ----------------------------------------------------------------
+            # We found a 0 LOC-ID but as per the L3-log header, some
+            # LOC-encoding scheme was in effect. So, it's sort-off odd
+            # to find a 0 LOC-ID. Report it, to tag investigation.
+            if decode_loc_id != L3_LOC_UNSET:
+                LOC = f" {loc=}"
+
+        elif decode_loc_id == L3_LOC_UNSET and (msg_fibase + loc) in src_locs:
+
+            # ----------------------------------------------------------------
+            # Call-sites of l3_log_srcloc() log the offset of their
+            # L3_SRC_LOC{} descriptor, which was copied into the log-file.
+            UNPACK_LOC = src_locs[msg_fibase + loc]
+            LOC = f" {UNPACK_LOC}"
+
+        elif decode_loc_id == L3_LOC_UNSET:
+
+            # ----------------------------------------------------------------
+            # This is a potential error somewhere, that no LOC-encoding scheme
+            # was in-effect in the build, but we found a non-zero LOC-ID!
+            LOC = f" {loc=}"
+
+        elif decode_loc_id == L3_LOC_DEFAULT:
+            # ----------------------------------------------------------------
+            # Unpack location-IDs by table lookup, cached, to speed-up
+            # unpacking of L3 log-dumps with millions of log-entries.
+            UNPACK_LOC = loc_decode(loc_decoders, log['loc_decoder_bin'], loc)
+
+            LOC = f" {UNPACK_LOC}"
+
+        elif decode_loc_id == L3_LOC_ELF_ENCODING:
+            LOC = f" {loc=}"
+
+        elif decode_loc_id == L3_LOC_RETADDR and OS_UNAME_S == 'Linux' and msg_bin:
+            # ----------------------------------------------------------------
+            # Symbolize the return address into the call-site against the
+            # binary that logged it, as the msg is.
+            UNPACK_LOC = retaddr_symbolize(msg_bin, msg_fibase, loc, symbolizers)
+            LOC = f" {UNPACK_LOC}"
+
+        elif decode_loc_id == L3_LOC_RETADDR:
+            LOC = f" {loc=}"
+
+        if spans is not None:
+            span_msg = span_msg_parse(msg_fmt)
+            if span_msg is not None:
+                (is_begin, name) = span_msg
+                key = (lognum, pid, tid, arg1)
+                if is_begin:
+                    open_spans[key] = (name, arg2)
+                elif key in open_spans and open_spans[key][0] == name:
+                    (_, begin_tsc) = open_spans.pop(key)
+                    duration = (arg2 - begin_tsc)
+                    unit = 'ticks'
+                    if log['clock'] is not None:
+                        duration = (duration * 1000000000) // log['clock'][2]
+                        unit = 'ns'
+                    spans.setdefault((name, unit), []).append(duration)
                 else:
-                    UNPACK_LOC = unpack_loc_prev
-
-                print(f"{tid=} {UNPACK_LOC} '{msg_text}'")
+                    unmatched_ends.append((name, tid, arg1))
+        elif ctf is not None:
+            (types, values) = ctf_event_args(msg_fmt, arg_types.get(msgptr, ()),
+                                             arg1, arg2, msg_bin, dwarf_enums)
+            ctf_log_entry(ctf, time_ns, pid, tid, msg_fmt, types, values)
+        elif trace is None and per_cpu is not None and decode_loc_id == L3_LOC_CPUID:
+            per_cpu.setdefault(loc, []).append(f"{tid=}{RING} '{msg_text}'{SAMPLED}")
+        elif trace is None:
+            print(f"{tid=}{RING}{LOC} '{msg_text}'{SAMPLED}")
+        else:
+            args = { 'arg1': arg1, 'arg2': arg2, 'ring': ring }
+            if decode_loc_id == L3_LOC_CPUID:
+                args['cpu'] = loc
+            elif LOC:
+                args['loc'] = UNPACK_LOC.strip() if UNPACK_LOC else loc
+            trace_log_entry(trace, time_ns, pid,
+                            log['name'] + (f" {pid=}" if procs else ''),
+                            tid, msg_fmt, msg_text, args)
+
+        # Build output-lists, if requested
+        if return_logentry_lists is True:
+            tid_list.append(tid)
+
+            # Strip trailing blanks, so we can match correctly against
+            # expected loc_list generated in pytest, l3_dump_test.py
+            loc_list.append(UNPACK_LOC.rstrip())
+
+            msg_list.append(msg_text)
+            arg1_list.append(arg1)
+            arg2_list.append(arg2)
+
+        nentries += 1
+
+    if trace is not None:
+        trace_close(trace)
+        print(f"Exported {nentries=} log-entries to trace-file:"
+              + f" {parsed_args.trace_file}")
+
+    if ctf is not None:
+        ctf_close(ctf)
+        print(f"Exported {nentries=} log-entries, of {len(ctf['classes'])}"
+              + f" messages, to CTF trace: {parsed_args.ctf_dir}")
 
-            elif decode_loc_id == L3_LOC_ELF_ENCODING:
-                print(f"{tid=} {loc=} '{msg_text}'")
-
-            # Build output-lists, if requested
-            if return_logentry_lists is True:
-                tid_list.append(tid)
+    print(f"Unpacked {nentries=} log-entries.")
 
-                # Strip trailing blanks, so we can match correctly against
-                # expected loc_list generated in pytest, l3_dump_test.py
-                loc_list.append(UNPACK_LOC.rstrip())
+    if spans is not None:
+        span_report(spans, open_spans, unmatched_ends)
 
-                msg_list.append(msg_text)
-                arg1_list.append(arg1)
-                arg2_list.append(arg2)
+    cpu_report(per_cpu, migrations)
 
-            nentries += 1
+    # Report estimated # of executions of sampled call-sites found in the log.
+    for log in logs:
+        sample_sites = log['sample_sites']
+        for msgptr, (nlogged, msg_fmt) in log['sample_counts'].items():
+            (policy, k, n) = sample_sites[msgptr]
+            print(f"Sampled call-site '{msg_fmt}': {nlogged} log-entries, "
+                  + f"{sample_policy_str(policy, k, n)}, "
+                  + f"~{sample_extrapolate(policy, k, n, nlogged)} executions.")
 
-    print(f"Unpacked {nentries=} log-entries.")
     return (nentries, tid_list, loc_list, msg_list, arg1_list, arg2_list)
 
 # #############################################################################
@@ -576,6 +2634,38 @@ def l3_parse_args(args:list):
     ''' + sys.argv[0]
         + ''' --log-file <L3-log-file> --binary <program-binary>
 
+- Unpack log-entries from the core file of a crashed program:
+    ''' + sys.argv[0]
+        + ''' --core-file <core-file> --binary <program-binary>
+
+- Unpack log-entries from the 'net' and 'storage' channels, merged:
+    ''' + sys.argv[0]
+        + ''' --log-file <L3-log-file> --binary <program-binary> --channel net --channel storage
+
+- Merge log-entries from the L3-log files of a server and a client, by time:
+    ''' + sys.argv[0]
+        + ''' --log-file <server-log-file> --binary <server-binary> --log-file <client-log-file> --binary <client-binary>
+
+- Export log-entries as trace-events, to view in https://ui.perfetto.dev:
+    ''' + sys.argv[0]
+        + ''' --log-file <L3-log-file> --binary <program-binary> --trace-file <trace.json>
+
+- Export log-entries as a CTF trace, to load in Trace Compass or babeltrace:
+    ''' + sys.argv[0]
+        + ''' --log-file <L3-log-file> --binary <program-binary> --ctf-dir <trace-dir>
+
+- Report latency percentiles and histograms of spans:
+    ''' + sys.argv[0]
+        + ''' --log-file <L3-log-file> --binary <program-binary> --spans
+
+- Print the timeline of each CPU, of a program built with L3_CPUID_ENABLED=1:
+    ''' + sys.argv[0]
+        + ''' --log-file <L3-log-file> --binary <program-binary> --per-cpu
+
+- Decode buffers logged by l3_log_bytes() by the decoders of a plugin file:
+    ''' + sys.argv[0]
+        + ''' --log-file <L3-log-file> --binary <program-binary> --decoders <decoders.py>
+
 NOTE: If <program-binary>, built with L3_LOC_ENABLED=1, invokes L3-logging,
       we expect to find a corresponding LOC-decoder binary named
       <program-binary>_loc, needed for decoding LOC-ID entries in the log-file.
@@ -583,15 +2673,25 @@ NOTE: If <program-binary>, built with L3_LOC_ENABLED=1, invokes L3-logging,
 
     # ======================================================================
     # Define required arguments supported by this script
-    parser.add_argument('--log-file', dest='log_file'
-                        , metavar='<log-file-name>'
-                        , required=True
-                        , help='L3 log-file name')
+    log_source = parser.add_mutually_exclusive_group(required=True)
+    log_source.add_argument('--log-file', dest='log_file'
+                            , metavar='<log-file-name>'
+                            , action='append'
+                            , help='L3 log-file name. Can be repeated, to merge'
+                                   + ' log-entries from several log-files.')
+
+    log_source.add_argument('--core-file', dest='core_file'
+                            , metavar='<core-file-name>'
+                            , help='Core file of crashed program, to extract'
+                                   + ' the L3-log from')
 
     parser.add_argument('--binary', dest='prog_binary'
                         , metavar='<program-binary>'
-                        , required=True
-                        , help='Program binary generating L3 logging')
+                        , action='append'
+                        , help='Program binary generating L3 logging. Repeat'
+                               + ' for each --log-file, if they differ. Not'
+                               + ' needed if the log-file has the format'
+                               + ' strings of its log-entries.')
 
     # ======================================================================
     # Optional arguments.
@@ -600,6 +2700,56 @@ NOTE: If <program-binary>, built with L3_LOC_ENABLED=1, invokes L3-logging,
                         , default=None
                         , help='Binary to decode LOC-ID encoded values.')
 
+    parser.add_argument('--channel', dest='channels'
+                        , metavar='<channel-name>'
+                        , action='append'
+                        , default=None
+                        , help='Unpack log-entries only from named channel.'
+                               + ' Can be repeated. The default ring is named'
+                               + ' \'' + L3_RING_DEFAULT_NAME + '\'.')
+
+    parser.add_argument('--list-channels', dest='list_channels'
+                        , action='store_true'
+                        , default=False
+                        , help='List channels found in the log-file')
+
+    parser.add_argument('--trace-file', dest='trace_file'
+                        , metavar='<trace-file-name>'
+                        , default=None
+                        , help='Export log-entries, instead of printing them,'
+                               + ' as Chrome JSON trace-events, to load in'
+                               + ' the Perfetto UI or chrome://tracing')
+
+    parser.add_argument('--ctf-dir', dest='ctf_dir'
+                        , metavar='<trace-dir>'
+                        , default=None
+                        , help='Export log-entries, instead of printing them,'
+                               + ' as a CTF 1.8 trace, into the directory, to'
+                               + ' load in Trace Compass or babeltrace')
+
+    parser.add_argument('--per-cpu', dest='per_cpu'
+                        , action='store_true'
+                        , default=False
+                        , help='Print log-entries grouped by the CPU they were'
+                               + ' logged on, for programs built with'
+                               + ' L3_CPUID_ENABLED=1')
+
+    parser.add_argument('--spans', dest='spans'
+                        , action='store_true'
+                        , default=False
+                        , help='Report latencies of spans logged by'
+                               + ' l3_span_begin() / l3_span_end(), instead'
+                               + ' of printing log-entries')
+
+    parser.add_argument('--decoders', dest='decoders'
+                        , metavar='<decoders-file.py>'
+                        , action='append'
+                        , default=None
+                        , help='Python file defining L3_DECODERS, a dict of'
+                               + ' decoders of buffers logged by'
+                               + ' l3_log_bytes(), by their tag. Can be'
+                               + ' repeated.')
+
     # ======================================================================
     # Debugging support
     parser.add_argument('--verbose', dest='verbose'
@@ -18,18 +18,28 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <signal.h>
 #include <sys/wait.h>
 #include <sys/syscall.h>
 #include <stdio.h>
+#include <time.h>
+#include <limits.h>
+#include <pthread.h>
 
 #if __APPLE__
 #include <mach-o/getsect.h>
-#include <pthread.h>
 #else
 #include <threads.h>
 #include <sys/single_threaded.h>
+#include <link.h>
 #endif  // __APPLE__
 
+#if __x86_64__
+#include <x86intrin.h>
+#endif  // __x86_64__
+
 #include <string.h>
 #include <assert.h>
 
@@ -39,11 +49,11 @@
 #include "loc.h"
 #endif  // L3_LOC_ENABLED
 
-// Define version of static assertion checking that works for both gcc and g++
-#ifdef __cplusplus
-#define L3_STATIC_ASSERT    static_assert
-#else
-#define L3_STATIC_ASSERT    _Static_assert
+// glibc registers, per thread, an rseq area whose cpu_id the kernel updates.
+#if defined(__GLIBC__)                                                      \
+    && ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 35)))
+#include <sys/rseq.h>
+#define L3_HAVE_RSEQ    1
 #endif
 
 #if __APPLE__
@@ -60,12 +70,17 @@
 typedef struct l3_entry
 {
     pid_t       tid;
+#ifdef L3_MSGID_ENABLED
+    uint32_t    msgid;      // See L3_MSGID()
+    uint64_t    tsc;        // Timestamp-counter when entry was logged
+#else   // L3_MSGID_ENABLED
 #ifdef L3_LOC_ENABLED
     loc_t       loc;
 #else
     uint32_t    loc;
 #endif  // L3_LOC_ENABLED
     const char *msg;
+#endif  // L3_MSGID_ENABLED
     uint64_t    arg1;
     uint64_t    arg2;
 } L3_ENTRY;
@@ -76,6 +91,27 @@ typedef struct l3_entry
  */
 #define L3_LOG_ENTRY_SZ (4 * sizeof(uint64_t))
 
+/**
+ * Continuation entry, following an entry logged by l3_log_str_mmap(), or by
+ * l3_log_bytes_mmap(), which carries more bytes of its string, or buffer.
+ * Its tid is the one's-complement of the writer's tid, so it is negative,
+ * which no entry's tid is, even with the slot # of a process sharing the
+ * log-file stashed in it.
+ */
+#define L3_ENTRY_CONT_LEN   (L3_LOG_ENTRY_SZ - sizeof(pid_t))
+
+typedef struct l3_entry_cont
+{
+    pid_t       ntid;       // ~tid
+    char        str[L3_ENTRY_CONT_LEN];
+} L3_ENTRY_CONT;
+
+L3_STATIC_ASSERT(sizeof(L3_ENTRY_CONT) == L3_LOG_ENTRY_SZ,
+                 "Expected sizeof(L3_ENTRY_CONT) == sizeof(L3_ENTRY).");
+
+// Bytes of a l3_log_str() string carried by the entry itself, in its arg2.
+#define L3_LOG_STR_HEAD_LEN sizeof(uint64_t)
+
 /**
  * Cross-check LOC's data structures. We need this to be true to ensure
  * that the sizeof(l3_entry) is unchanged w/LOC ON or OFF.
@@ -85,6 +121,74 @@ L3_STATIC_ASSERT(sizeof(loc_t) == sizeof(uint32_t),
                  "Expected sizeof(loc_t) == 4 bytes.");
 #endif  // L3_LOC_ENABLED
 
+/**
+ * Under L3_LOC_RETADDR, the loc field of a log-entry is, instead, the offset
+ * from the program's base-address of the return address of the logging
+ * function, i.e. of the call-site. l3_dump.py symbolizes it against the
+ * program binary. This needs no LOC-encoding, so it excludes L3_LOC_ENABLED.
+ */
+#ifdef L3_LOC_RETADDR
+
+#ifdef L3_LOC_ENABLED
+#error "L3_LOC_RETADDR and L3_LOC_ENABLED are mutually exclusive."
+#endif  // L3_LOC_ENABLED
+
+#define L3_RETADDR_LOC()                                                    \
+        ((uint32_t) ((uintptr_t) __builtin_return_address(0) - l3_fbase))
+
+// Entries redirected by l3__log_frozen() arrive with their call-site's loc.
+#define L3_CALLER_LOC(loc)  ((loc) ? (loc) : L3_RETADDR_LOC())
+
+#else   // L3_LOC_RETADDR
+
+#define L3_CALLER_LOC(loc)  (loc)
+
+#endif  // L3_LOC_RETADDR
+
+/**
+ * Under L3_MSGID_ENABLED, log-entries of the default ring-buffer identify
+ * their msg by a 32-bit message id, instead of by the 64-bit pointer. This
+ * frees room in the 32-byte entry for the timestamp-counter, so that entries
+ * of the default ring are also timestamped. The message id is the offset of
+ * msg from the program's base-address: a link-time constant of the call-site,
+ * which l3_dump.py resolves against the format strings in the log-file, or
+ * else in the program binary, as it does msg pointers. The entry has no room
+ * left for a loc, so this excludes LOC-encoding and L3_LOC_RETADDR.
+ */
+#ifdef L3_MSGID_ENABLED
+
+#if defined(L3_LOC_ENABLED) || defined(L3_LOC_RETADDR)
+#error "L3_MSGID_ENABLED excludes L3_LOC_ENABLED and L3_LOC_RETADDR."
+#endif  // L3_LOC_ENABLED || L3_LOC_RETADDR
+
+#define L3_MSGID(msg)   ((uint32_t) ((uintptr_t) (msg) - l3_fbase))
+
+#endif  // L3_MSGID_ENABLED
+
+/**
+ * Under L3_CPUID_ENABLED, the loc field of a log-entry is, instead, the # of
+ * the CPU that the entry was logged on, so that l3_dump.py can report per-CPU
+ * timelines, and threads migrating between CPUs across their entries. This
+ * excludes the other uses of the loc field.
+ */
+#ifdef L3_CPUID_ENABLED
+
+#if defined(L3_LOC_ENABLED) || defined(L3_LOC_RETADDR) || defined(L3_MSGID_ENABLED)
+#error "L3_CPUID_ENABLED excludes L3_LOC_ENABLED, L3_LOC_RETADDR and L3_MSGID_ENABLED."
+#endif  // L3_LOC_ENABLED || L3_LOC_RETADDR || L3_MSGID_ENABLED
+
+#if __APPLE__
+#error "L3_CPUID_ENABLED is not supported on Mac/OSX."
+#endif  // __APPLE__
+
+#define L3_ENTRY_LOC(loc)   l3_cpu()
+
+#else   // L3_CPUID_ENABLED
+
+#define L3_ENTRY_LOC(loc)   (loc)
+
+#endif  // L3_CPUID_ENABLED
+
 /**
  * Definitions for L3_LOG.{platform, loc_type} fields. This field is used to
  * reliably identify the provenance of a L3-log file so that the appropriate
@@ -104,6 +208,8 @@ enum loc_type_t
       L3_LOG_LOC_NONE                   =  ((uint8_t) 0)
     , L3_LOG_LOC_ENCODING               // ((uint8_t) 1)
     , L3_LOG_LOC_ELF_ENCODING           // ((uint8_t) 2)
+    , L3_LOG_LOC_RETADDR                // ((uint8_t) 3)
+    , L3_LOG_LOC_CPUID                  // ((uint8_t) 4)
 };
 
 /**
@@ -113,14 +219,216 @@ typedef struct l3_log
 {
     uint64_t        idx;
     uint64_t        fbase_addr;
-    uint32_t        pad0;
+    uint32_t        flags;      // L3_LOG_FLAG_*
     uint16_t        log_size;   // # of log-entries == L3_MAX_SLOTS
     uint8_t         platform;
     uint8_t         loc_type;
-    uint64_t        pad1;
+    uint64_t        freeze_idx; // See l3_freeze_after(); l3.S knows its offset
     L3_ENTRY        slots[L3_MAX_SLOTS];
 } L3_LOG;
 
+/**
+ * L3_LOG.freeze_idx of a ring that is not frozen. Writers that consume an
+ * idx >= freeze_idx do not log to the ring.
+ */
+#define L3_UNFROZEN     UINT64_MAX
+
+/**
+ * L3_LOG.flags: Log-file is shared by processes attached by l3_init_shared(),
+ * and is ready for them to attach to.
+ */
+#define L3_LOG_FLAG_SHARED      ((uint32_t) 0x1)
+
+/**
+ * L3_LOG.flags: Log-entries of the default ring-buffer carry a message id and
+ * a timestamp, instead of a loc and msg pointer. See L3_MSGID().
+ */
+#define L3_LOG_FLAG_MSGID       ((uint32_t) 0x2)
+
+/**
+ * L3_LOG.flags: Threads log to the rings of their NUMA nodes, instead of to
+ * the default ring-buffer. See l3_init_numa().
+ */
+#define L3_LOG_FLAG_NUMA        ((uint32_t) 0x4)
+
+#ifdef L3_MSGID_ENABLED
+#define L3_LOG_FLAGS_LAYOUT     L3_LOG_FLAG_MSGID
+#else
+#define L3_LOG_FLAGS_LAYOUT     ((uint32_t) 0)
+#endif  // L3_MSGID_ENABLED
+
+/**
+ * L3 Log-file extension records:
+ *
+ * Additional (variable-sized) information describing the log-entries is
+ * appended to the log-file, following the ring-buffer of L3_LOG{}, as a
+ * sequence of extension records. Each record is a L3_EXT{} header followed
+ * by 'size' bytes of payload. The sequence is terminated by a record of
+ * type L3_EXT_END. The L3-dump script walks these records to decode the
+ * log-entries.
+ */
+typedef struct l3_ext
+{
+    uint32_t        type;       // One of ext_type_t
+    uint32_t        pad0;
+    uint64_t        size;       // # of payload bytes following this header
+} L3_EXT;
+
+enum ext_type_t
+{
+      L3_EXT_END                        = 0
+    , L3_EXT_SAMPLE_SITES               // Array of L3_SAMPLE_SITE{}
+    , L3_EXT_RING                       // L3_RING{}, followed by its slots
+    , L3_EXT_MODULES                    // Array of L3_MODULE{}
+    , L3_EXT_PROCS                      // L3_PROCS{}
+    , L3_EXT_CLOCK                      // L3_CLOCK{}
+    , L3_EXT_STRINGS                    // Sequence of L3_STRING{}
+    , L3_EXT_ARG_TYPES                  // Array of L3_ARG_TYPES{}
+    , L3_EXT_SRC_LOCS                   // Sequence of L3_SRC_LOC_REC{}
+    , L3_EXT_PAD                        // Padding, to page-align the next
+};
+
+/**
+ * Clock anchor, recorded by l3_init(): The timestamp-counter, l3_tsc(), read
+ * at a known wall-clock time, and its rate. It converts timestamps of
+ * log-entries to wall-clock time, to merge logs from different processes.
+ */
+typedef struct l3_clock
+{
+    uint64_t        tsc;
+    uint64_t        realtime_ns;    // CLOCK_REALTIME when 'tsc' was read
+    uint64_t        tsc_per_sec;
+    uint64_t        pad0;
+} L3_CLOCK;
+
+/**
+ * Format string of L3-logging call-sites, with the address it is logged by,
+ * so that the L3-dump script can decode log-entries without the program
+ * binary. Followed by the string, NUL-terminated, padded to L3_EXT_ALIGN.
+ */
+typedef struct l3_string
+{
+    uint64_t        addr;       // msg pointer logged by call-site
+    uint32_t        size;       // # of bytes of this record, incl. string
+    uint32_t        len;        // strlen() of string
+} L3_STRING;
+
+#define L3_STRING_SIZE(len) (sizeof(L3_STRING) + L3_ROUNDUP(((len) + 1), L3_EXT_ALIGN))
+
+/**
+ * L3_SRC_LOC{} descriptor of a call-site of l3_log_srcloc(), with the address
+ * its offset is logged from. Followed by the file name and the function name,
+ * each NUL-terminated, padded together to L3_EXT_ALIGN.
+ */
+typedef struct l3_src_loc_rec
+{
+    uint64_t        addr;       // of the L3_SRC_LOC{} descriptor
+    uint32_t        size;       // # of bytes of this record, incl. strings
+    uint32_t        line;
+    uint32_t        column;
+    uint32_t        file_len;   // strlen() of file name
+    uint32_t        func_len;   // strlen() of function name
+    uint32_t        pad0;
+} L3_SRC_LOC_REC;
+
+#define L3_SRC_LOC_REC_SIZE(file_len, func_len)                             \
+        (sizeof(L3_SRC_LOC_REC)                                             \
+            + L3_ROUNDUP(((file_len) + 1 + (func_len) + 1), L3_EXT_ALIGN))
+
+// Interval over which the rate of the timestamp-counter is calibrated.
+#define L3_CLOCK_CALIBRATE_NS   1000000ULL
+
+// # of attempts to read the timestamp-counter and CLOCK_REALTIME together.
+#define L3_CLOCK_NREADS         5
+
+#define L3_NS_PER_SEC           1000000000ULL
+
+/**
+ * Log entry in the named rings, other than the default ring-buffer in
+ * L3_LOG{}. Each entry is stamped with a timestamp, and with the default
+ * ring's idx at the time the entry was logged, so that the L3-dump script
+ * can merge entries from all rings into one chronological sequence.
+ */
+typedef struct l3_xentry
+{
+    pid_t       tid;
+#ifdef L3_LOC_ENABLED
+    loc_t       loc;
+#else
+    uint32_t    loc;
+#endif  // L3_LOC_ENABLED
+    const char *msg;
+    uint64_t    arg1;
+    uint64_t    arg2;
+    uint64_t    tsc;        // Timestamp-counter when entry was logged
+    uint64_t    seq;        // L3_LOG()->idx of default ring when logged
+} L3_XENTRY;
+
+#define L3_XENTRY_SZ        (6 * sizeof(uint64_t))
+
+L3_STATIC_ASSERT(sizeof(L3_XENTRY) == L3_XENTRY_SZ,
+                 "Expected sizeof(L3_XENTRY) == 48 bytes.");
+
+/**
+ * L3 named ring: A ring-buffer of L3_XENTRY{}s, with its own idx so that
+ * writers to one ring never contend with writers to another ring.
+ * The # of slots is a power-of-2.
+ */
+#define L3_RING_NAME_LEN    40
+
+typedef struct l3_ring
+{
+    uint64_t        idx;
+    uint32_t        nslots;
+    uint32_t        pad0;
+    uint64_t        freeze_idx; // As in L3_LOG{}
+    char            name[L3_RING_NAME_LEN];
+    L3_XENTRY       slots[];
+} L3_RING;
+
+L3_STATIC_ASSERT(sizeof(L3_RING) == 64,
+                 "Expected sizeof(L3_RING) header == 64 bytes.");
+
+#define L3_RING_SIZE(nslots)    (sizeof(L3_RING) + ((nslots) * sizeof(L3_XENTRY)))
+
+/**
+ * Table of processes attached to a log-file shared by l3_init_shared().
+ * Each process claims a slot, and records where its binary is loaded, so
+ * that msg pointers logged by different binaries can be decoded. The slot
+ * # is stashed in the bits of the tid logged, above pid_max of 2^22.
+ */
+#define L3_MAX_PROCS        64
+#define L3_PROC_SLOT_SHIFT  22
+#define L3_PROC_PATH_LEN    240
+
+typedef struct l3_proc
+{
+    pid_t           pid;
+    uint32_t        pad0;
+    uint64_t        fbase_addr;
+    char            path[L3_PROC_PATH_LEN];     // Of the process's binary
+} L3_PROC;
+
+typedef struct l3_procs
+{
+    uint32_t        nprocs;
+    uint32_t        pad0;
+    uint64_t        pad1;
+    L3_PROC         procs[L3_MAX_PROCS];        // procs[slot - 1]
+} L3_PROCS;
+
+L3_STATIC_ASSERT(sizeof(L3_PROC) == 256,
+                 "Expected sizeof(L3_PROC) == 256 bytes.");
+
+/**
+ * Name of the ring to which high-severity log-entries are logged.
+ */
+#define L3_RING_IMPORTANT_NAME  "important"
+
+#define L3_EXT_ALIGN        sizeof(L3_EXT)
+
+#define L3_ROUNDUP(n, a)    ((((n) + (a) - 1) / (a)) * (a))
+
 #define L3_ARRAY_LEN(arr)   (sizeof(arr) / sizeof(*arr))
 
 #define L3_MIN(a, b)        ((a) > (b) ? (b) : (a))
@@ -143,10 +451,34 @@ L3_STATIC_ASSERT((L3_ARRAY_LEN(L3_logtype_name) == L3_LOGTYPE_MAX),
 L3_LOG *l3_log = NULL;      // L3_LOG_MMAP: Also referenced in l3.S for
                             // fast-logging.
 
+L3_LOG *l3_log_ring = NULL; // L3_LOG_MMAP: mmap()'ed L3_LOG{}. Differs from
+                            // l3_log while writers are redirected to
+L3_LOG *l3_scratch = NULL;  // this scratch ring, when l3_log is frozen.
+
+size_t  l3_log_mapsize = 0; // L3_LOG_MMAP: Size of mmap()'ed L3_LOG{} + exts.
+
+L3_RING *l3_important = NULL;   // L3_LOG_MMAP: Ring for high-severity entries
+
+int     l3_log_mmap_fd = -1;    // L3_LOG_MMAP: fd of mmap()'ed log-file
+
+size_t  l3_ext_end_offs = 0;    // L3_LOG_MMAP: File-offset of L3_EXT_END
+
+size_t  l3_ext_base_end_offs = 0;   // L3_LOG_MMAP: Offset of L3_EXT_END in
+                                    // mapping of L3_LOG{}, before channels
+
+L3_PROCS *l3_procs = NULL;      // L3_LOG_MMAP: Processes sharing the log-file
+static uint32_t l3_proc_slot = 0;   // This process's slot in l3_procs
+static int      l3_log_shared = 0;  // Set while creating a shared log-file
+
 FILE *  l3_log_fh = NULL;   // L3_LOG_FPRINTF: Opened by fopen()
 
 int     l3_log_fd = -1;     // L3_LOG_WRITE: Opened by open()
 
+uint64_t l3_fbase = 0;      // Base-address of program's binary. Also
+                            // referenced in l3.S, under L3_LOC_RETADDR.
+
+int     l3_numa = 0;        // L3_LOG_MMAP: Set by l3_init_numa().
+
 /**
  * The L3-dump script expects a specific layout and its parsing routines
  * hard-code the log-header size to be these many bytes. (The overlay of
@@ -156,6 +488,9 @@ int     l3_log_fd = -1;     // L3_LOG_WRITE: Opened by open()
 L3_STATIC_ASSERT(offsetof(L3_LOG,slots) == sizeof(L3_ENTRY),
                 "Expected layout of L3_LOG{} is != 32 bytes.");
 
+L3_STATIC_ASSERT(offsetof(L3_LOG,freeze_idx) == 24,
+                "l3.S expects L3_LOG{}.freeze_idx at offset 24 bytes.");
+
 /**
  * ****************************************************************************
  * Function Prototypes
@@ -184,116 +519,552 @@ getBaseAddress() {
 }
 #endif  // __APPLE__
 
+/**
+ * The tid logged by the calling thread, with its process's slot in a shared
+ * log-file, if any. Cached on the 1st log-entry of each thread, as threads
+ * are created after l3_init(). See l3_tid().
+ */
 L3_THREAD_LOCAL pid_t l3_my_tid;
 
+static void l3_crash_thread_init(void);
+
 /**
- * ****************************************************************************
- * l3_log_init() - Initialize L3-logging sub-system, selecting the type of
- * logging to be performed.
- * ****************************************************************************
+ * l3_tid_init() - Cache the calling thread's tid, on its 1st log-entry.
+ * Also install the thread's alternate stack for crash handlers, if any.
  */
-int
-l3_log_init(const l3_log_t logtype, const char *path)
+static __attribute__((noinline)) pid_t
+l3_tid_init(void)
 {
-    int rv = 0;
-    switch (logtype) {
-      case L3_LOG_MMAP:         // L3_LOG_DEFAULT:
-        rv = l3_init(path);
-        break;
+    l3_crash_thread_init();
+    l3_my_tid = (L3_GET_TID() | (l3_proc_slot << L3_PROC_SLOT_SHIFT));
+    return l3_my_tid;
+}
 
-      case L3_LOG_FPRINTF:
-        rv = l3_init_fprintf(path);
-        break;
+static inline pid_t
+l3_tid(void)
+{
+    pid_t tid = l3_my_tid;
+    if (__builtin_expect((tid == 0), 0)) {
+        tid = l3_tid_init();
+    }
+    return tid;
+}
 
-      case L3_LOG_WRITE:
-      case L3_LOG_WRITE_MSG:
-        rv = l3_init_write(path);
-        break;
+#if !__APPLE__
+/**
+ * Linker-generated bounds of the descriptors emitted by the sampling
+ * caller-macros, l3_log_every_n() and friends. Weak, as they are undefined
+ * for programs that have no sampled call-sites.
+ */
+extern const L3_SAMPLE_SITE __start_l3_sample_sites[] __attribute__((weak));
+extern const L3_SAMPLE_SITE __stop_l3_sample_sites[] __attribute__((weak));
+#endif  // !__APPLE__
 
-      default:
-        printf("Unsupported L3-logging type=%d\n", logtype);
-        return -1;
+L3_STATIC_ASSERT(sizeof(L3_SAMPLE_SITE) == L3_SAMPLE_SITE_ALIGN,
+                 "Expected sizeof(L3_SAMPLE_SITE) == L3_SAMPLE_SITE_ALIGN.");
+
+L3_STATIC_ASSERT(sizeof(L3_ARG_TYPES) == L3_ARG_TYPES_ALIGN,
+                 "Expected sizeof(L3_ARG_TYPES) == L3_ARG_TYPES_ALIGN.");
+
+/**
+ * ****************************************************************************
+ * l3_strings_size() - # of bytes of L3_STRING{}s, for the format strings of
+ * call-sites found in the 'l3_log_fmts' section. See L3_FMT().
+ * ****************************************************************************
+ */
+static size_t
+l3_strings_size(void)
+{
+    size_t size = 0;
+#if !__APPLE__
+    for (const char *const *fmt = __start_l3_log_fmts;
+         fmt < __stop_l3_log_fmts; fmt++) {
+        size += L3_STRING_SIZE(strlen(*fmt));
     }
-    return rv;
+#endif  // !__APPLE__
+    return size;
 }
 
 /**
  * ****************************************************************************
- * l3_log_deinit() - De-initialize L3-logging sub-system, selecting the type
- * of logging that was being performed. Finalize the file and close its handle.
+ * l3_strings_init() - Fill-in the L3_STRING{}s, sized by l3_strings_size(),
+ * at 'str'. Call-sites inlined in several places are listed more than once.
  * ****************************************************************************
  */
-int
-l3_log_deinit(const l3_log_t logtype)
+static void
+l3_strings_init(L3_STRING *str)
 {
-    int rv = 0;
-    switch (logtype) {
-      case L3_LOG_MMAP:         // L3_LOG_DEFAULT:
-        rv = munmap(l3_log, sizeof(*l3_log));
-        break;
+#if !__APPLE__
+    for (const char *const *fmt = __start_l3_log_fmts;
+         fmt < __stop_l3_log_fmts; fmt++) {
+        str->addr = (uint64_t) *fmt;
+        str->len = strlen(*fmt);
+        str->size = L3_STRING_SIZE(str->len);
+        memcpy((str + 1), *fmt, (str->len + 1));
+        str = (L3_STRING *) ((char *) str + str->size);
+    }
+#endif  // !__APPLE__
+}
 
-      case L3_LOG_FPRINTF:
-        fflush(l3_log_fh);
-        rv = fclose(l3_log_fh);
-        break;
+/**
+ * ****************************************************************************
+ * l3_arg_types_size() - # of bytes of descriptors of the argument types of
+ * call-sites of l3::log<>().
+ * ****************************************************************************
+ */
+static size_t
+l3_arg_types_size(void)
+{
+#if __APPLE__
+    return 0;
+#else
+    return ((const char *) __stop_l3_arg_types
+                - (const char *) __start_l3_arg_types);
+#endif  // __APPLE__
+}
 
-      case L3_LOG_WRITE:
-#if !defined(__APPLE__)
-        syncfs(l3_log_fd);
+/**
+ * ****************************************************************************
+ * l3_src_locs_size() - # of bytes of L3_SRC_LOC_REC{}s, for the descriptors
+ * of call-sites found in the 'l3_src_locs' section. See l3_log_srcloc().
+ * ****************************************************************************
+ */
+static size_t
+l3_src_locs_size(void)
+{
+    size_t size = 0;
+#if !__APPLE__
+    for (const L3_SRC_LOC *const *loc = __start_l3_src_locs;
+         loc < __stop_l3_src_locs; loc++) {
+        size += L3_SRC_LOC_REC_SIZE(strlen((*loc)->file),
+                                    strlen((*loc)->function));
+    }
 #endif  // !__APPLE__
-        rv = close(l3_log_fd);
-        break;
+    return size;
+}
 
-      default:
-        printf("Unsupported L3-logging type=%d\n", logtype);
-        return -1;
-    }
-    if (rv) {
-        fprintf(stderr, "Error closing L3 log-file for logging type '%s'"
-                        ", errno=%d\n",
-                l3_logtype_name(logtype), errno);
+/**
+ * ****************************************************************************
+ * l3_src_locs_init() - Fill-in the L3_SRC_LOC_REC{}s, sized by
+ * l3_src_locs_size(), at 'rec'.
+ * ****************************************************************************
+ */
+static void
+l3_src_locs_init(L3_SRC_LOC_REC *rec)
+{
+#if !__APPLE__
+    for (const L3_SRC_LOC *const *loc = __start_l3_src_locs;
+         loc < __stop_l3_src_locs; loc++) {
+        rec->addr = (uint64_t) *loc;
+        rec->line = (*loc)->line;
+        rec->column = (*loc)->column;
+        rec->file_len = strlen((*loc)->file);
+        rec->func_len = strlen((*loc)->function);
+        rec->size = L3_SRC_LOC_REC_SIZE(rec->file_len, rec->func_len);
+        char *names = (char *) (rec + 1);
+        memcpy(names, (*loc)->file, (rec->file_len + 1));
+        memcpy((names + rec->file_len + 1), (*loc)->function,
+               (rec->func_len + 1));
+        rec = (L3_SRC_LOC_REC *) ((char *) rec + rec->size);
     }
-    return rv;
+#endif  // !__APPLE__
 }
 
 /**
  * ****************************************************************************
- * L3's default logging sub-system, using mmap()'ed files.
+ * l3_sample_sites_size() - # of bytes of sampled call-site descriptors.
+ * ****************************************************************************
  */
-int
-l3_init(const char *path)
+static size_t
+l3_sample_sites_size(void)
 {
-    int fd = -1;
-    if (path)
-    {
-        fd = open(path, O_RDWR | O_CREAT, 0666);
-        if (fd == -1) {
-            return -1;
-        }
+#if __APPLE__
+    return 0;
+#else
+    return ((const char *) __stop_l3_sample_sites
+                - (const char *) __start_l3_sample_sites);
+#endif  // __APPLE__
+}
 
-        if (lseek(fd, sizeof(L3_LOG), SEEK_SET) < 0) {
-            return -1;
-        }
-        if (write(fd, &fd, 1) != 1) {
-            return -1;
-        }
-    }
+/**
+ * Named channels opened by l3_channel_open(). Each channel is a L3_RING{},
+ * appended to the extension records of the log-file and mmap()'ed
+ * separately, as the file grows. The "important" ring is found in the
+ * mapping of L3_LOG{}, so it is registered with a 0-length mapping.
+ */
+typedef struct l3_channel_map
+{
+    L3_RING    *ring;
+    void       *base;       // Start of the separate mapping of 'ring'
+    size_t      len;        // Length of the separate mapping of 'ring'
+    size_t      offs;       // File-offset of the separate mapping of 'ring'
+} L3_CHANNEL_MAP;
 
-    l3_my_tid = L3_GET_TID();
+/**
+ * Rings of the NUMA nodes, under l3_init_numa(), named "numa<node>". Each is
+ * opened as a named channel, from a pool separate from that of channels opened
+ * by l3_channel_open(). The CPU # fits in 12 bits of TSC_AUX, so this is also
+ * the limit of CPUs whose node is looked up.
+ */
+#define L3_RING_NUMA_PREFIX "numa"
+#define L3_MAX_NUMA_NODES   16
+#define L3_MAX_CPUS         4096
 
-    l3_log = (L3_LOG *) mmap(NULL, sizeof(*l3_log), PROT_READ|PROT_WRITE,
-                             MAP_SHARED, fd, 0);
-    if (l3_log == MAP_FAILED) {
-        return -1;
-    }
+static L3_CHANNEL_MAP   l3_channels[L3_MAX_CHANNELS + L3_MAX_NUMA_NODES];
+static uint32_t         l3_nchannels = 0;   // Including rings of NUMA nodes
+static int              l3_channels_lock = 0;
 
-    // Technically, this is not needed as mmap() is guaranteed to return
-    // zero-filled pages. We do this just to be clear where the idx begins.
-    l3_log->idx = 0;
+static L3_RING *        l3_numa_rings[L3_MAX_NUMA_NODES];
+static uint32_t         l3_numa_nrings = 0;
+static uint8_t          l3_cpu_node[L3_MAX_CPUS];
+
+static void l3_numa_reset(void);
+
+/**
+ * ****************************************************************************
+ * l3_tsc() - Timestamp used to order entries across rings.
+ * ****************************************************************************
+ */
+static inline uint64_t
+l3_tsc(void)
+{
+#if __x86_64__
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((ts.tv_sec * L3_NS_PER_SEC) + ts.tv_nsec);
+#endif  // __x86_64__
+}
+
+#if !__APPLE__
+/**
+ * ****************************************************************************
+ * l3_cpu() - The CPU that the calling thread is running on, without the cost
+ * of a sched_getcpu() call where the rseq area or rdtscp give it to us.
+ * ****************************************************************************
+ */
+static inline uint32_t
+l3_cpu(void)
+{
+#if L3_HAVE_RSEQ
+    const struct rseq *rseq = (const struct rseq *)
+                ((char *) __builtin_thread_pointer() + __rseq_offset);
+    int32_t cpu = (int32_t) __atomic_load_n(&rseq->cpu_id, __ATOMIC_RELAXED);
+
+    // -ve if rseq is not registered, e.g. under GLIBC_TUNABLES.
+    if (__builtin_expect((cpu >= 0), 1)) {
+        return (uint32_t) cpu;
+    }
+#endif  // L3_HAVE_RSEQ
+
+#if __x86_64__
+    // Linux keeps the CPU # in TSC_AUX, with the NUMA node above bit 12.
+    unsigned int aux;
+    __rdtscp(&aux);
+    return (aux & 0xfff);
+#else
+    return (uint32_t) sched_getcpu();
+#endif  // __x86_64__
+}
+#endif  // !__APPLE__
+
+static inline uint64_t
+l3_clock_ns(clockid_t clockid)
+{
+    struct timespec ts;
+    clock_gettime(clockid, &ts);
+    return ((ts.tv_sec * L3_NS_PER_SEC) + ts.tv_nsec);
+}
+
+/**
+ * ****************************************************************************
+ * l3_clock_init() - Record the clock anchor. On x86, the rate of the TSC is
+ * calibrated against CLOCK_MONOTONIC, by spinning for a brief interval.
+ * ****************************************************************************
+ */
+static void
+l3_clock_init(L3_CLOCK *clock)
+{
+#if __x86_64__
+    uint64_t ns0 = l3_clock_ns(CLOCK_MONOTONIC);
+    uint64_t tsc0 = l3_tsc();
+    uint64_t ns;
+    do {
+        ns = (l3_clock_ns(CLOCK_MONOTONIC) - ns0);
+    } while (ns < L3_CLOCK_CALIBRATE_NS);
+    clock->tsc_per_sec = (((l3_tsc() - tsc0) * L3_NS_PER_SEC) / ns);
+#else
+    clock->tsc_per_sec = L3_NS_PER_SEC;
+#endif  // __x86_64__
+
+    // Anchor to the CLOCK_REALTIME read in the briefest interval of TSC reads.
+    uint64_t interval = UINT64_MAX;
+    for (int ictr = 0; ictr < L3_CLOCK_NREADS; ictr++) {
+        uint64_t tsc_before = l3_tsc();
+        uint64_t realtime_ns = l3_clock_ns(CLOCK_REALTIME);
+        uint64_t tsc_after = l3_tsc();
+        if ((tsc_after - tsc_before) < interval) {
+            interval = (tsc_after - tsc_before);
+            clock->tsc = (tsc_before + (interval / 2));
+            clock->realtime_ns = realtime_ns;
+        }
+    }
+}
+
+/**
+ * ****************************************************************************
+ * l3_ring_init() - Initialize an (already zero'ed) named ring of 'nslots'.
+ * ****************************************************************************
+ */
+static void
+l3_ring_init(L3_RING *ring, const char *name, uint32_t nslots)
+{
+    ring->idx = 0;
+    ring->nslots = nslots;
+    ring->freeze_idx = L3_UNFROZEN;
+    strncpy(ring->name, name, (sizeof(ring->name) - 1));
+}
+
+/**
+ * ****************************************************************************
+ * l3_ext_add() - Append an extension record of 'size' bytes of 'payload'
+ * at 'ext'. Returns the location to append the next extension record.
+ * ****************************************************************************
+ */
+static L3_EXT *
+l3_ext_add(L3_EXT *ext, uint32_t type, const void *payload, size_t size)
+{
+    ext->type = type;
+    ext->size = L3_ROUNDUP(size, L3_EXT_ALIGN);
+    if (payload) {
+        memcpy((ext + 1), payload, size);
+    } else {
+        memset((ext + 1), 0, size);
+    }
+    return (L3_EXT *) ((char *) (ext + 1) + ext->size);
+}
+
+/**
+ * ****************************************************************************
+ * l3_ext_area_size() - Size of the extension records following L3_LOG{}.
+ * ****************************************************************************
+ */
+static size_t
+l3_ext_area_size(void)
+{
+    size_t size = sizeof(L3_EXT);   // L3_EXT_END
+
+    size += sizeof(L3_EXT) + L3_RING_SIZE(L3_IMPORTANT_SLOTS);
+
+    size_t nbytes = l3_sample_sites_size();
+    if (nbytes) {
+        size += sizeof(L3_EXT) + L3_ROUNDUP(nbytes, L3_EXT_ALIGN);
+    }
+
+    if (l3_log_shared) {
+        size += sizeof(L3_EXT) + sizeof(L3_PROCS);
+    }
+
+    size += sizeof(L3_EXT) + sizeof(L3_CLOCK);
+
+    nbytes = l3_strings_size();
+    if (nbytes) {
+        size += sizeof(L3_EXT) + nbytes;
+    }
+
+    nbytes = l3_arg_types_size();
+    if (nbytes) {
+        size += sizeof(L3_EXT) + nbytes;
+    }
+
+    nbytes = l3_src_locs_size();
+    if (nbytes) {
+        size += sizeof(L3_EXT) + nbytes;
+    }
+    return size;
+}
+
+/**
+ * ****************************************************************************
+ * l3_ext_area_init() - Fill-in the extension records following L3_LOG{}.
+ * ****************************************************************************
+ */
+static void
+l3_ext_area_init(L3_EXT *ext)
+{
+    l3_important = (L3_RING *) (ext + 1);
+    ext = l3_ext_add(ext, L3_EXT_RING, NULL,
+                     L3_RING_SIZE(L3_IMPORTANT_SLOTS));
+    l3_ring_init(l3_important, L3_RING_IMPORTANT_NAME, L3_IMPORTANT_SLOTS);
+
+    size_t nbytes = l3_sample_sites_size();
+    if (nbytes) {
+#if !__APPLE__
+        ext = l3_ext_add(ext, L3_EXT_SAMPLE_SITES,
+                         __start_l3_sample_sites, nbytes);
+#endif  // !__APPLE__
+    }
+
+    l3_procs = NULL;
+    l3_proc_slot = 0;
+    if (l3_log_shared) {
+        l3_procs = (L3_PROCS *) (ext + 1);
+        ext = l3_ext_add(ext, L3_EXT_PROCS, NULL, sizeof(L3_PROCS));
+    }
+
+    L3_CLOCK *clock = (L3_CLOCK *) (ext + 1);
+    ext = l3_ext_add(ext, L3_EXT_CLOCK, NULL, sizeof(L3_CLOCK));
+    l3_clock_init(clock);
+
+    // Make the log-file self-describing, by copying the format strings.
+    nbytes = l3_strings_size();
+    if (nbytes) {
+        L3_STRING *strings = (L3_STRING *) (ext + 1);
+        ext = l3_ext_add(ext, L3_EXT_STRINGS, NULL, nbytes);
+        l3_strings_init(strings);
+    }
+
+    nbytes = l3_arg_types_size();
+    if (nbytes) {
+#if !__APPLE__
+        ext = l3_ext_add(ext, L3_EXT_ARG_TYPES, __start_l3_arg_types, nbytes);
+#endif  // !__APPLE__
+    }
+
+    nbytes = l3_src_locs_size();
+    if (nbytes) {
+        L3_SRC_LOC_REC *src_locs = (L3_SRC_LOC_REC *) (ext + 1);
+        ext = l3_ext_add(ext, L3_EXT_SRC_LOCS, NULL, nbytes);
+        l3_src_locs_init(src_locs);
+    }
+
+    // Channels opened later will be appended, starting at L3_EXT_END.
+    l3_ext_end_offs = ((char *) ext - (char *) l3_log);
+    l3_ext_base_end_offs = l3_ext_end_offs;
+    l3_ext_add(ext, L3_EXT_END, NULL, 0);
+
+    l3_channels[0].ring = l3_important;
+    l3_channels[0].base = NULL;
+    l3_channels[0].len = 0;
+    l3_channels[0].offs = 0;
+    l3_nchannels = 1;
+}
+
+/**
+ * ****************************************************************************
+ * l3_log_init() - Initialize L3-logging sub-system, selecting the type of
+ * logging to be performed.
+ * ****************************************************************************
+ */
+int
+l3_log_init(const l3_log_t logtype, const char *path)
+{
+    int rv = 0;
+    switch (logtype) {
+      case L3_LOG_MMAP:         // L3_LOG_DEFAULT:
+        rv = l3_init(path);
+        break;
+
+      case L3_LOG_FPRINTF:
+        rv = l3_init_fprintf(path);
+        break;
+
+      case L3_LOG_WRITE:
+      case L3_LOG_WRITE_MSG:
+        rv = l3_init_write(path);
+        break;
+
+      default:
+        printf("Unsupported L3-logging type=%d\n", logtype);
+        return -1;
+    }
+    return rv;
+}
+
+/**
+ * ****************************************************************************
+ * l3_log_deinit() - De-initialize L3-logging sub-system, selecting the type
+ * of logging that was being performed. Finalize the file and close its handle.
+ * ****************************************************************************
+ */
+int
+l3_log_deinit(const l3_log_t logtype)
+{
+    int rv = 0;
+    switch (logtype) {
+      case L3_LOG_MMAP:         // L3_LOG_DEFAULT:
+        for (uint32_t cctr = 0; cctr < l3_nchannels; cctr++) {
+            if (l3_channels[cctr].len) {
+                munmap(l3_channels[cctr].base, l3_channels[cctr].len);
+            }
+        }
+        l3_nchannels = 0;
+        l3_numa_reset();
+        rv = munmap(l3_log, l3_log_mapsize);
+        if (l3_log_mmap_fd != -1) {
+            close(l3_log_mmap_fd);
+            l3_log_mmap_fd = -1;
+        }
+        break;
+
+      case L3_LOG_FPRINTF:
+        fflush(l3_log_fh);
+        rv = fclose(l3_log_fh);
+        break;
+
+      case L3_LOG_WRITE:
+#if !defined(__APPLE__)
+        syncfs(l3_log_fd);
+#endif  // !__APPLE__
+        rv = close(l3_log_fd);
+        break;
+
+      default:
+        printf("Unsupported L3-logging type=%d\n", logtype);
+        return -1;
+    }
+    if (rv) {
+        fprintf(stderr, "Error closing L3 log-file for logging type '%s'"
+                        ", errno=%d\n",
+                l3_logtype_name(logtype), errno);
+    }
+    return rv;
+}
+
+static char l3_log_path[PATH_MAX];  // L3_LOG_MMAP: Path of log-file, if any
+static int  l3_atfork_registered = 0;
+
+static void l3_atfork_prepare(void);
+static void l3_atfork_parent(void);
+static void l3_atfork_child(void);
+
+/**
+ * l3_atfork_register() - Note down the log-file's path, from which children
+ * derive theirs, and register the fork() handlers, once.
+ */
+static void
+l3_atfork_register(const char *path)
+{
+    l3_log_path[0] = '\0';
+    if (path) {
+        strncpy(l3_log_path, path, (sizeof(l3_log_path) - 1));
+    }
+    if (!l3_atfork_registered) {
+        pthread_atfork(l3_atfork_prepare, l3_atfork_parent, l3_atfork_child);
+        l3_atfork_registered = 1;
+    }
+}
 
+/**
+ * l3_fbase_addr() - Find the base-address where the program's binary, and
+ * so its rodata, is loaded.
+ */
+static int
+l3_fbase_addr(uint64_t *fbase_addr)
+{
 #if __APPLE__
-     l3_log->fbase_addr = getBaseAddress();
-     l3_log->platform = L3_LOG_PLATFORM_MACOSX;
+    *fbase_addr = getBaseAddress();
 #else
     /* Linux: Let's find where rodata is loaded. */
     Dl_info info;
@@ -302,7 +1073,70 @@ l3_init(const char *path)
         errno = L3_DLADDR_NOT_FOUND_ERRNO;
         return -1;
     }
-    l3_log->fbase_addr = (intptr_t) info.dli_fbase;
+    *fbase_addr = (intptr_t) info.dli_fbase;
+#endif  // __APPLE__
+    l3_fbase = *fbase_addr;
+    return 0;
+}
+
+/**
+ * ****************************************************************************
+ * L3's default logging sub-system, using mmap()'ed files.
+ */
+int
+l3_init(const char *path)
+{
+    int fd = -1;
+    int flags = (MAP_PRIVATE | MAP_ANONYMOUS);  // In-memory ring, if !path
+
+    // The ring-buffer is followed by extension records describing it.
+    size_t mapsize = sizeof(L3_LOG) + l3_ext_area_size();
+    if (path)
+    {
+        flags = MAP_SHARED;
+        fd = open(path, O_RDWR | O_CREAT, 0666);
+        if (fd == -1) {
+            return -1;
+        }
+
+        if (ftruncate(fd, mapsize) < 0) {
+            return -1;
+        }
+    }
+
+    l3_my_tid = L3_GET_TID();
+
+    l3_log = (L3_LOG *) mmap(NULL, mapsize, PROT_READ|PROT_WRITE,
+                             flags, fd, 0);
+    if (l3_log == MAP_FAILED) {
+        return -1;
+    }
+    l3_log_mapsize = mapsize;
+    l3_log_ring = l3_log;
+    l3_log->freeze_idx = L3_UNFROZEN;
+
+    // Rings of NUMA nodes are only logged to after l3_init_numa().
+    l3_numa_reset();
+
+    // Keep the file open, to grow it as named channels are opened.
+    if (l3_log_mmap_fd != -1) {
+        close(l3_log_mmap_fd);
+    }
+    l3_log_mmap_fd = fd;
+    l3_ext_area_init((L3_EXT *) (l3_log + 1));
+
+    l3_atfork_register(path);
+
+    // Technically, this is not needed as mmap() is guaranteed to return
+    // zero-filled pages. We do this just to be clear where the idx begins.
+    l3_log->idx = 0;
+
+    if (l3_fbase_addr(&l3_log->fbase_addr)) {
+        return -1;
+    }
+#if __APPLE__
+     l3_log->platform = L3_LOG_PLATFORM_MACOSX;
+#else
      l3_log->platform = L3_LOG_PLATFORM_LINUX;
 #endif  // __APPLE__
 
@@ -317,9 +1151,14 @@ l3_init(const char *path)
     l3_log->loc_type = L3_LOG_LOC_ELF_ENCODING;
 #elif L3_LOC_ENABLED
     l3_log->loc_type = L3_LOG_LOC_ENCODING;
+#elif defined(L3_LOC_RETADDR)
+    l3_log->loc_type = L3_LOG_LOC_RETADDR;
+#elif defined(L3_CPUID_ENABLED)
+    l3_log->loc_type = L3_LOG_LOC_CPUID;
 #endif  // L3_LOC_ELF_ENABLED
 
     l3_log->log_size = L3_MAX_SLOTS;
+    l3_log->flags |= L3_LOG_FLAGS_LAYOUT;
 
     // printf("fbase_addr=%" PRIu64 " (0x%llx)\n", l3_log->fbase_addr, l3_log->fbase_addr);
     // printf("sizeof(L3_LOG)=%ld, header=%lu bytes\n",
@@ -374,6 +1213,56 @@ l3_init_write(const char *path)
 
 // ****************************************************************************
 
+#ifdef L3_LOC_ENABLED
+void l3__log_frozen(const loc_t loc, const char *msg,
+                    const uint64_t arg1, const uint64_t arg2);
+void l3__log_numa(const loc_t loc, const char *msg,
+                  const uint64_t arg1, const uint64_t arg2);
+void l3__log_tid(const loc_t loc, const char *msg,
+                 const uint64_t arg1, const uint64_t arg2);
+#else
+void l3__log_frozen(const uint32_t loc, const char *msg,
+                    const uint64_t arg1, const uint64_t arg2);
+void l3__log_numa(const uint32_t loc, const char *msg,
+                  const uint64_t arg1, const uint64_t arg2);
+void l3__log_tid(const uint32_t loc, const char *msg,
+                 const uint64_t arg1, const uint64_t arg2);
+#endif  // L3_LOC_ENABLED
+
+/**
+ * l3_entry_fill() - Fill-in the log-entry at 'entry' of the default ring.
+ */
+static inline void
+#ifdef L3_LOC_ENABLED
+l3_entry_fill(L3_ENTRY *entry, const char *msg,
+              const uint64_t arg1, const uint64_t arg2, loc_t loc)
+#else
+l3_entry_fill(L3_ENTRY *entry, const char *msg,
+              const uint64_t arg1, const uint64_t arg2, uint32_t loc)
+#endif
+{
+    entry->tid = l3_tid();
+
+#ifdef L3_MSGID_ENABLED
+    entry->msgid = L3_MSGID(msg);
+    entry->tsc = l3_tsc();
+#else   // L3_MSGID_ENABLED
+
+#ifdef L3_LOC_ENABLED
+    entry->loc = (loc_t) loc;
+#else   // L3_LOC_ENABLED
+    // 0, unless logged by l3_log_srcloc(), or under L3_LOC_RETADDR.
+    // The CPU # under L3_CPUID_ENABLED.
+    entry->loc = L3_ENTRY_LOC(loc);
+#endif  // L3_LOC_ENABLED
+
+    entry->msg = msg;
+#endif  // L3_MSGID_ENABLED
+
+    entry->arg1 = arg1;
+    entry->arg2 = arg2;
+}
+
 /**
  * l3_log_mmap() - 'C' interface to "slow" L3-logging.
  *
@@ -391,29 +1280,1445 @@ l3_log_mmap(const char *msg, const uint64_t arg1, const uint64_t arg2,
             uint32_t loc)
 #endif
 {
+    L3_LOG *log = l3_log;
+
+#ifdef L3_LOC_RETADDR
+    loc = L3_CALLER_LOC(loc);
+#endif  // L3_LOC_RETADDR
+
+#if !__APPLE__
+    if (__builtin_expect(l3_numa, 0)) {
+        l3__log_numa(loc, msg, arg1, arg2);
+        return;
+    }
+#endif  // !__APPLE__
 
 #if  __APPLE__
-    int idx = __sync_fetch_and_add(&l3_log->idx, 1);
+    uint64_t idx = __sync_fetch_and_add(&log->idx, 1);
 #else
-    int idx = __libc_single_threaded ? l3_log->idx++
-                                     : __sync_fetch_and_add(&l3_log->idx, 1);
+    uint64_t idx = __libc_single_threaded ? log->idx++
+                                          : __sync_fetch_and_add(&log->idx, 1);
 #endif  // __APPLE__
+    if (__builtin_expect((idx >= log->freeze_idx), 0)) {
+        l3__log_frozen(loc, msg, arg1, arg2);
+        return;
+    }
     idx %= L3_MAX_SLOTS;
-    l3_log->slots[idx].tid = l3_my_tid;
+    l3_entry_fill(&log->slots[idx], msg, arg1, arg2, loc);
+}
 
+/**
+ * l3_ring_log() - Log an entry to a named ring.
+ */
+static inline void
 #ifdef L3_LOC_ENABLED
-    l3_log->slots[idx].loc = (loc_t) loc;
-#else   // L3_LOC_ENABLED
-
-#ifdef DEBUG
-    assert(l3_log->slots[idx].loc == 0);
-#endif  // DEBUG
-
-#endif  // L3_LOC_ENABLED
-
-    l3_log->slots[idx].msg = msg;
-    l3_log->slots[idx].arg1 = arg1;
-    l3_log->slots[idx].arg2 = arg2;
+l3_ring_log(L3_RING *ring, const char *msg,
+            const uint64_t arg1, const uint64_t arg2, loc_t loc)
+#else
+l3_ring_log(L3_RING *ring, const char *msg,
+            const uint64_t arg1, const uint64_t arg2, uint32_t loc)
+#endif
+{
+#if  __APPLE__
+    uint64_t idx = __sync_fetch_and_add(&ring->idx, 1);
+#else
+    uint64_t idx = __libc_single_threaded ? ring->idx++
+                                          : __sync_fetch_and_add(&ring->idx, 1);
+#endif  // __APPLE__
+    if (__builtin_expect((idx >= ring->freeze_idx), 0)) {
+        return;
+    }
+    L3_XENTRY *slot = &ring->slots[idx & (ring->nslots - 1)];
+
+    slot->tid = l3_tid();
+    slot->loc = L3_ENTRY_LOC(loc);
+    slot->msg = msg;
+    slot->arg1 = arg1;
+    slot->arg2 = arg2;
+    slot->tsc = l3_tsc();
+    slot->seq = l3_log->idx;
+}
+
+/**
+ * l3_log_important_mmap() - 'C' interface to log high-severity entries to
+ * the ring named "important", which is not flooded by the default ring's
+ * log-entries.
+ */
+void
+#ifdef L3_LOC_ENABLED
+l3_log_important_mmap(const char *msg, const uint64_t arg1, const uint64_t arg2,
+                      loc_t loc)
+#else
+l3_log_important_mmap(const char *msg, const uint64_t arg1, const uint64_t arg2,
+                      uint32_t loc)
+#endif
+{
+    l3_ring_log(l3_important, msg, arg1, arg2, L3_CALLER_LOC(loc));
+}
+
+/**
+ * l3_log_ch_mmap() - 'C' interface to log to a named channel.
+ */
+void
+#ifdef L3_LOC_ENABLED
+l3_log_ch_mmap(l3_channel_t ch, const char *msg,
+               const uint64_t arg1, const uint64_t arg2, loc_t loc)
+#else
+l3_log_ch_mmap(l3_channel_t ch, const char *msg,
+               const uint64_t arg1, const uint64_t arg2, uint32_t loc)
+#endif
+{
+    l3_ring_log(ch, msg, arg1, arg2, L3_CALLER_LOC(loc));
+}
+
+/**
+ * Span ids are unique to each thread, as l3_dump.py pairs the entries of
+ * spans by thread.
+ */
+static __thread l3_span_t l3_span_seq = 0;
+
+/**
+ * l3_span_begin_mmap() - 'C' interface to begin a span: Log 'msg' with a new
+ * span id and the timestamp-counter. Returns the span id.
+ */
+l3_span_t
+#ifdef L3_LOC_ENABLED
+l3_span_begin_mmap(const char *msg, const loc_t loc)
+#else
+l3_span_begin_mmap(const char *msg, const uint32_t loc)
+#endif
+{
+    l3_span_t span = ++l3_span_seq;
+    l3_log_mmap(msg, span, l3_tsc(), L3_CALLER_LOC(loc));
+    return span;
+}
+
+/**
+ * l3_span_end_mmap() - 'C' interface to end a span: Log 'msg' with the span
+ * id returned by l3_span_begin_mmap() and the timestamp-counter.
+ */
+void
+#ifdef L3_LOC_ENABLED
+l3_span_end_mmap(const char *msg, l3_span_t span, const loc_t loc)
+#else
+l3_span_end_mmap(const char *msg, l3_span_t span, const uint32_t loc)
+#endif
+{
+    l3_log_mmap(msg, span, l3_tsc(), L3_CALLER_LOC(loc));
+}
+
+/**
+ * l3_channel_find() - Find an open channel by its name. Returns NULL if
+ * not found. Caller holds l3_channels_lock.
+ */
+static L3_RING *
+l3_channel_find(const char *name)
+{
+    for (uint32_t cctr = 0; cctr < l3_nchannels; cctr++) {
+        if (strncmp(l3_channels[cctr].ring->name, name,
+                    (L3_RING_NAME_LEN - 1)) == 0) {
+            return l3_channels[cctr].ring;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * l3_ring_append() - Append a ring named 'name', of 'nslots' entries, as an
+ * extension record, at the current L3_EXT_END record, after growing the
+ * log-file to accommodate it. Only the tail of the file, starting at the page
+ * holding L3_EXT_END, is mmap()'ed. Caller holds l3_channels_lock.
+ *
+ * With 'page_align', the ring is placed at the start of a page, following a
+ * L3_EXT_PAD record, so that none of its pages are shared with the records
+ * before it, and the ring is placed wherever its pages are 1st touched.
+ *
+ * Records' types are set last, so a concurrent reader of the log-file never
+ * walks into an incompletely initialized record.
+ */
+static L3_RING *
+l3_ring_append(const char *name, uint32_t nslots, int page_align)
+{
+    size_t pagesize = (size_t) sysconf(_SC_PAGESIZE);
+    size_t ringsize = L3_ROUNDUP(L3_RING_SIZE(nslots), L3_EXT_ALIGN);
+    size_t pad_offs = l3_ext_end_offs;
+    size_t ext_offs = pad_offs;
+    if (page_align && ((pad_offs + sizeof(L3_EXT)) % pagesize)) {
+        ext_offs = (L3_ROUNDUP((pad_offs + (2 * sizeof(L3_EXT))), pagesize)
+                        - sizeof(L3_EXT));
+    }
+    size_t end_offs = ext_offs + sizeof(L3_EXT) + ringsize;
+    size_t map_offs = pad_offs & ~(pagesize - 1);
+    size_t map_len = (end_offs + sizeof(L3_EXT)) - map_offs;
+
+    char *base = MAP_FAILED;
+    if (l3_log_mmap_fd == -1) {
+        base = (char *) mmap(NULL, map_len, PROT_READ|PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    } else if (ftruncate(l3_log_mmap_fd, (end_offs + sizeof(L3_EXT))) == 0) {
+        base = (char *) mmap(NULL, map_len, PROT_READ|PROT_WRITE,
+                             MAP_SHARED, l3_log_mmap_fd, map_offs);
+    }
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    // The grown file, hence the new L3_EXT_END record, is zero-filled.
+    L3_EXT *ext = (L3_EXT *) (base + (ext_offs - map_offs));
+    L3_RING *ring = (L3_RING *) (ext + 1);
+    l3_ring_init(ring, name, nslots);
+    ext->size = ringsize;
+    __sync_synchronize();
+    ext->type = L3_EXT_RING;
+
+    if (ext_offs != pad_offs) {
+        L3_EXT *pad = (L3_EXT *) (base + (pad_offs - map_offs));
+        pad->size = (ext_offs - pad_offs - sizeof(L3_EXT));
+        __sync_synchronize();
+        pad->type = L3_EXT_PAD;
+    }
+
+    l3_channels[l3_nchannels].ring = ring;
+    l3_channels[l3_nchannels].base = base;
+    l3_channels[l3_nchannels].len = map_len;
+    l3_channels[l3_nchannels].offs = map_offs;
+    l3_nchannels++;
+    l3_ext_end_offs = end_offs;
+    return ring;
+}
+
+/**
+ * l3_channel_open() - Open a named channel of (at least) 'nslots' entries,
+ * appended to the log-file by l3_ring_append().
+ */
+l3_channel_t
+l3_channel_open(const char *name, uint32_t nslots)
+{
+    if (!l3_log || !name || !*name || !nslots || (nslots > L3_MAX_SLOTS)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    // Round-up to a power-of-2, so that slots are indexed by masking.
+    uint32_t pow2 = 1;
+    while (pow2 < nslots) {
+        pow2 <<= 1;
+    }
+    nslots = pow2;
+
+    while (__sync_lock_test_and_set(&l3_channels_lock, 1)) {
+        ;
+    }
+
+    // Processes sharing a log-file cannot grow it independently.
+    L3_RING *ring = l3_channel_find(name);
+    if (   ring || l3_procs
+        || ((l3_nchannels - l3_numa_nrings) == L3_MAX_CHANNELS)) {
+        if (!ring) {
+            errno = (l3_procs ? ENOTSUP : ENOSPC);
+        }
+        __sync_lock_release(&l3_channels_lock);
+        return ring;
+    }
+
+    ring = l3_ring_append(name, nslots, 0);
+
+    __sync_lock_release(&l3_channels_lock);
+    return ring;
+}
+
+/**
+ * ****************************************************************************
+ * NUMA-aware rings: Under l3_init_numa(), threads log to a ring of the NUMA
+ * node that they are running on, instead of the default ring. So, threads of
+ * different nodes do not contend for the cache-line of one idx, nor store to
+ * slots on a remote node. The rings of all online nodes are appended to the
+ * log-file by l3_init_numa(), which touches only their headers. Their slots
+ * are first touched by the writers, who all run on that node. So, the kernel
+ * places the slots on the node, as it does not apply mbind() policies to pages
+ * of the page-cache backing the log-file. Entries of the rings are timestamped,
+ * and l3_dump.py merges them chronologically.
+ * ****************************************************************************
+ */
+
+/**
+ * l3_numa_reset() - Stop logging to the rings of NUMA nodes.
+ */
+static void
+l3_numa_reset(void)
+{
+    l3_numa = 0;
+    l3_numa_nrings = 0;
+    memset(l3_numa_rings, 0, sizeof(l3_numa_rings));
+}
+
+#if !__APPLE__
+/**
+ * l3_sysfs_range() - Parse the next range, "<first>[-<last>]", of a list,
+ * e.g. "0-3,8-11", from a file in sysfs. Returns 0 at the end of the list.
+ */
+static int
+l3_sysfs_range(FILE *fh, unsigned int *first, unsigned int *last)
+{
+    if (fscanf(fh, "%u", first) != 1) {
+        return 0;
+    }
+    *last = *first;
+    if ((fgetc(fh) == '-') && (fscanf(fh, "%u", last) == 1)) {
+        fgetc(fh);
+    }
+    return 1;
+}
+
+/**
+ * l3_numa_nodes_init() - Find the online NUMA nodes, flagged in 'online', and
+ * fill-in l3_cpu_node[], mapping CPUs to their node, from the cpulist, e.g.
+ * "0-3,8-11", of each node in sysfs. Kernels without NUMA support list no
+ * nodes in sysfs, so node 0 is online, with all CPUs. CPUs not listed, e.g.
+ * as they are offline, map to the 1st online node.
+ *
+ * Returns 0 on success; -1 if a node is beyond L3_MAX_NUMA_NODES.
+ */
+static int
+l3_numa_nodes_init(uint8_t *online)
+{
+    unsigned int first;
+    unsigned int last;
+
+    memset(online, 0, L3_MAX_NUMA_NODES);
+    FILE *fh = fopen("/sys/devices/system/node/online", "r");
+    if (!fh) {
+        online[0] = 1;
+    }
+    while (fh && l3_sysfs_range(fh, &first, &last)) {
+        for (unsigned int node = first; node <= last; node++) {
+            if (node >= L3_MAX_NUMA_NODES) {
+                fclose(fh);
+                errno = ENOSPC;
+                return -1;
+            }
+            online[node] = 1;
+        }
+    }
+    if (fh) {
+        fclose(fh);
+    }
+
+    uint32_t node = 0;
+    while (!online[node]) {
+        node++;
+    }
+    memset(l3_cpu_node, node, sizeof(l3_cpu_node));
+
+    for (node = 0; node < L3_MAX_NUMA_NODES; node++) {
+        char path[64];
+        snprintf(path, sizeof(path),
+                 "/sys/devices/system/node/node%u/cpulist", node);
+        fh = (online[node] ? fopen(path, "r") : NULL);
+        while (fh && l3_sysfs_range(fh, &first, &last)) {
+            for (unsigned int cpu = first;
+                 (cpu <= last) && (cpu < L3_MAX_CPUS); cpu++) {
+                l3_cpu_node[cpu] = (uint8_t) node;
+            }
+        }
+        if (fh) {
+            fclose(fh);
+        }
+    }
+    return 0;
+}
+
+/**
+ * l3__log_numa() - Log an entry to the ring of the NUMA node that the caller
+ * is running on. Also jumped to from l3__log_fast(), in l3.S, with the same
+ * arguments.
+ */
+void
+#ifdef L3_LOC_ENABLED
+l3__log_numa(const loc_t loc, const char *msg,
+             const uint64_t arg1, const uint64_t arg2)
+#else
+l3__log_numa(const uint32_t loc, const char *msg,
+             const uint64_t arg1, const uint64_t arg2)
+#endif  // L3_LOC_ENABLED
+{
+    uint32_t cpu = l3_cpu();
+    L3_RING *ring = l3_numa_rings[l3_cpu_node[cpu & (L3_MAX_CPUS - 1)]];
+    l3_ring_log(ring, msg, arg1, arg2, loc);
+}
+#endif  // !__APPLE__
+
+/**
+ * l3_init_numa() - Initialize L3-logging to the log-file at 'path', as
+ * l3_init() does, with threads logging to the ring of their NUMA node.
+ */
+int
+l3_init_numa(const char *path)
+{
+#if __APPLE__
+    (void) path;
+    errno = ENOTSUP;
+    return -1;
+#else
+    uint8_t online[L3_MAX_NUMA_NODES];
+    if (l3_numa_nodes_init(online)) {
+        fprintf(stderr, "%s: More than %d NUMA nodes are not supported.\n",
+                __func__, L3_MAX_NUMA_NODES);
+        return -1;
+    }
+
+    int rv = l3_init(path);
+    if (rv) {
+        return rv;
+    }
+
+    while (__sync_lock_test_and_set(&l3_channels_lock, 1)) {
+        ;
+    }
+    for (uint32_t node = 0; (rv == 0) && (node < L3_MAX_NUMA_NODES); node++) {
+        char name[L3_RING_NAME_LEN];
+        snprintf(name, sizeof(name), L3_RING_NUMA_PREFIX "%u", node);
+        if (online[node]) {
+            l3_numa_rings[node] = l3_ring_append(name, L3_MAX_SLOTS, 1);
+            rv = (l3_numa_rings[node] ? 0 : -1);
+            l3_numa_nrings += (rv == 0);
+        }
+    }
+    __sync_lock_release(&l3_channels_lock);
+
+    if (rv == 0) {
+        l3_log->flags |= L3_LOG_FLAG_NUMA;
+        l3_numa = 1;
+        return 0;
+    }
+
+    int error = errno;
+    fprintf(stderr, "%s: Error opening rings of NUMA nodes. errno=%d\n",
+            __func__, error);
+    l3_log_deinit(L3_LOG_MMAP);
+    errno = error;
+    return -1;
+#endif  // __APPLE__
+}
+
+/**
+ * ****************************************************************************
+ * Flight-recorder freeze: l3_freeze_after(n) sets L3_LOG.freeze_idx to the
+ * idx, n entries from now. Writers already compare the idx they consume
+ * against freeze_idx, which is in the same cache-line as idx, so the normal
+ * fast path costs one not-taken branch. The 1st writer to consume an
+ * idx >= freeze_idx, freezes the named rings and redirects l3_log to a
+ * scratch ring. The ring then holds exactly the window of entries up to
+ * freeze_idx, until it is dumped or thawed by l3_thaw().
+ * ****************************************************************************
+ */
+
+/**
+ * l3_freeze_rings() - Stop logging to the named rings.
+ */
+static void
+l3_freeze_rings(void)
+{
+    for (uint32_t cctr = 0; cctr < l3_nchannels; cctr++) {
+        L3_RING *ring = l3_channels[cctr].ring;
+        if (ring->freeze_idx == L3_UNFROZEN) {
+            ring->freeze_idx = ring->idx;
+        }
+    }
+}
+
+/**
+ * l3__log_frozen() - Log an entry, whose writer consumed an idx at or
+ * beyond the freeze_idx of the ring it logged to, to the scratch ring.
+ * Also invoked from l3__log_fast(), in l3.S, with the same arguments.
+ */
+void
+#ifdef L3_LOC_ENABLED
+l3__log_frozen(const loc_t loc, const char *msg,
+               const uint64_t arg1, const uint64_t arg2)
+#else
+l3__log_frozen(const uint32_t loc, const char *msg,
+               const uint64_t arg1, const uint64_t arg2)
+#endif  // L3_LOC_ENABLED
+{
+    L3_LOG *log = l3_log;
+    if (log != l3_scratch) {
+        l3_freeze_rings();
+        __sync_bool_compare_and_swap(&l3_log, log, l3_scratch);
+    }
+    l3_log_mmap(msg, arg1, arg2, loc);
+}
+
+/**
+ * l3__log_tid() - Log the 1st entry of a thread, whose tid is not cached yet.
+ * Invoked from l3__log_fast(), in l3.S, with the same arguments.
+ */
+void
+#ifdef L3_LOC_ENABLED
+l3__log_tid(const loc_t loc, const char *msg,
+            const uint64_t arg1, const uint64_t arg2)
+#else
+l3__log_tid(const uint32_t loc, const char *msg,
+            const uint64_t arg1, const uint64_t arg2)
+#endif  // L3_LOC_ENABLED
+{
+    l3_tid_init();
+    l3_log_mmap(msg, arg1, arg2, loc);
+}
+
+/**
+ * l3_log_conts() - Log an entry, with 'arg2', followed by the continuation
+ * entries carrying 'nbytes' of 'data', to the default ring. The entry's arg1
+ * is 'arg1' plus the # of bytes of 'data' logged.
+ *
+ * The entry, and its continuation entries, are reserved by one increment of
+ * the idx. Should the ring freeze part-way through them, only the bytes of
+ * 'data' that fit in the entries before the freeze_idx are logged.
+ */
+static void
+#ifdef L3_LOC_ENABLED
+l3_log_conts(const char *msg, const uint64_t arg1, const uint64_t arg2,
+             const char *data, size_t nbytes, loc_t loc)
+#else
+l3_log_conts(const char *msg, const uint64_t arg1, const uint64_t arg2,
+             const char *data, size_t nbytes, uint32_t loc)
+#endif  // L3_LOC_ENABLED
+{
+    L3_LOG *log = l3_log;
+    uint64_t nslots = (1 + ((nbytes + L3_ENTRY_CONT_LEN - 1)
+                                / L3_ENTRY_CONT_LEN));
+
+#if  __APPLE__
+    uint64_t idx = __sync_fetch_and_add(&log->idx, nslots);
+#else
+    uint64_t idx;
+    if (__libc_single_threaded) {
+        idx = log->idx;
+        log->idx += nslots;
+    } else {
+        idx = __sync_fetch_and_add(&log->idx, nslots);
+    }
+#endif  // __APPLE__
+    uint64_t freeze_idx = log->freeze_idx;
+    if (__builtin_expect(((idx + nslots) > freeze_idx), 0)) {
+        if (idx >= freeze_idx) {
+            if (log != l3_scratch) {
+                l3_freeze_rings();
+                __sync_bool_compare_and_swap(&l3_log, log, l3_scratch);
+            }
+            l3_log_conts(msg, arg1, arg2, data, nbytes, loc);
+            return;
+        }
+        nslots = (freeze_idx - idx);
+        if (nbytes > ((nslots - 1) * L3_ENTRY_CONT_LEN)) {
+            nbytes = ((nslots - 1) * L3_ENTRY_CONT_LEN);
+        }
+    }
+
+    l3_entry_fill(&log->slots[idx % L3_MAX_SLOTS], msg, (arg1 + nbytes), arg2,
+                  loc);
+
+    for (uint64_t sctr = 1; sctr < nslots; sctr++) {
+        L3_ENTRY_CONT *cont
+            = (L3_ENTRY_CONT *) &log->slots[(idx + sctr) % L3_MAX_SLOTS];
+        size_t len = ((nbytes > L3_ENTRY_CONT_LEN) ? L3_ENTRY_CONT_LEN : nbytes);
+        cont->ntid = ~l3_tid();
+        memcpy(cont->str, data, len);
+        memset((cont->str + len), 0, (L3_ENTRY_CONT_LEN - len));
+        data += len;
+        nbytes -= len;
+    }
+}
+
+/**
+ * l3_log_str_mmap() - 'C' interface to log up to L3_LOG_STR_MAX bytes of a
+ * string, 'str', to the default ring. See l3_log_str().
+ */
+void
+#ifdef L3_LOC_ENABLED
+l3_log_str_mmap(const char *msg, const char *str, size_t len, loc_t loc)
+#else
+l3_log_str_mmap(const char *msg, const char *str, size_t len, uint32_t loc)
+#endif  // L3_LOC_ENABLED
+{
+#ifdef L3_LOC_RETADDR
+    loc = L3_CALLER_LOC(loc);
+#endif  // L3_LOC_RETADDR
+
+    if (len > L3_LOG_STR_MAX) {
+        len = L3_LOG_STR_MAX;
+    }
+    uint64_t head = 0;
+    size_t head_len = ((len < L3_LOG_STR_HEAD_LEN) ? len : L3_LOG_STR_HEAD_LEN);
+    memcpy(&head, str, head_len);
+    l3_log_conts(msg, head_len, head, (str + head_len), (len - head_len), loc);
+}
+
+/**
+ * l3_log_bytes_mmap() - 'C' interface to log up to L3_LOG_BYTES_MAX bytes of
+ * a buffer, 'buf', of type 'tag', to the default ring. See l3_log_bytes().
+ */
+void
+#ifdef L3_LOC_ENABLED
+l3_log_bytes_mmap(const char *msg, const char *tag, const void *buf,
+                  size_t len, loc_t loc)
+#else
+l3_log_bytes_mmap(const char *msg, const char *tag, const void *buf,
+                  size_t len, uint32_t loc)
+#endif  // L3_LOC_ENABLED
+{
+#ifdef L3_LOC_RETADDR
+    loc = L3_CALLER_LOC(loc);
+#endif  // L3_LOC_RETADDR
+
+    if (len > L3_LOG_BYTES_MAX) {
+        len = L3_LOG_BYTES_MAX;
+    }
+    l3_log_conts(msg, 0, (uint64_t) tag, (const char *) buf, len, loc);
+}
+
+/**
+ * l3_scratch_alloc() - Allocate the scratch ring, once.
+ */
+static int
+l3_scratch_alloc(void)
+{
+    if (!l3_scratch) {
+        L3_LOG *scratch = (L3_LOG *) mmap(NULL, sizeof(L3_LOG),
+                                          PROT_READ|PROT_WRITE,
+                                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (scratch == MAP_FAILED) {
+            return -1;
+        }
+        scratch->freeze_idx = L3_UNFROZEN;
+        if (!__sync_bool_compare_and_swap(&l3_scratch, NULL, scratch)) {
+            munmap(scratch, sizeof(L3_LOG));
+        }
+    }
+    return 0;
+}
+
+/**
+ * l3_freeze_after() - Freeze the ring after 'n' more log-entries.
+ */
+int
+l3_freeze_after(uint64_t n)
+{
+    if (!l3_log_ring) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    // Writers are redirected to a scratch ring, once frozen, so that they
+    // need not check again whether the ring is frozen.
+    if (l3_scratch_alloc()) {
+        return -1;
+    }
+
+    l3_log_ring->freeze_idx = (l3_log_ring->idx + n);
+
+    // Rings of NUMA nodes do not consume the default ring's idx; so each
+    // is frozen after 'n' more entries of its own.
+    for (uint32_t nctr = 0; l3_numa && (nctr < L3_MAX_NUMA_NODES); nctr++) {
+        L3_RING *ring = l3_numa_rings[nctr];
+        if (ring) {
+            ring->freeze_idx = (ring->idx + n);
+        }
+    }
+    __sync_synchronize();
+    if (n == 0) {
+        l3_freeze_rings();
+        l3_log = l3_scratch;
+    }
+    return 0;
+}
+
+/**
+ * l3_freeze() - Freeze the ring now.
+ */
+int
+l3_freeze(void)
+{
+    return l3_freeze_after(0);
+}
+
+/**
+ * l3_thaw() - Resume logging to the frozen rings. Writers that were
+ * redirected to the scratch ring, or dropped, consumed idx's beyond the
+ * freeze_idx. Rewind idx, so that the frozen window is retained as the
+ * history preceding the entries logged after the thaw.
+ */
+int
+l3_thaw(void)
+{
+    if (!l3_log_ring) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (uint32_t cctr = 0; cctr < l3_nchannels; cctr++) {
+        L3_RING *ring = l3_channels[cctr].ring;
+        if (ring->idx > ring->freeze_idx) {
+            ring->idx = ring->freeze_idx;
+        }
+        ring->freeze_idx = L3_UNFROZEN;
+    }
+
+    if (l3_log_ring->idx > l3_log_ring->freeze_idx) {
+        l3_log_ring->idx = l3_log_ring->freeze_idx;
+    }
+    l3_log_ring->freeze_idx = L3_UNFROZEN;
+    __sync_synchronize();
+    l3_log = l3_log_ring;
+    return 0;
+}
+
+/**
+ * ****************************************************************************
+ * Crash-time capture of the ring: l3_init_crash_dump() pre-opens the file to
+ * write the ring to, snapshots the module map and installs handlers for
+ * SIGSEGV, SIGABRT and SIGBUS. The handler writes the header, the ring, its
+ * extension records, the module map and the named channels, in the layout
+ * of a L3-log file, with a single writev(). So, an in-memory ring, i.e.
+ * l3_init(NULL), gives flight-recorder data without the write-back of
+ * file-backed pages during normal operation.
+ * ****************************************************************************
+ */
+#define L3_MAX_MODULES      64
+#define L3_MODULE_PATH_LEN  248
+
+typedef struct l3_module
+{
+    uint64_t    base;       // Load-address of the module
+    char        path[L3_MODULE_PATH_LEN];
+} L3_MODULE;
+
+L3_STATIC_ASSERT(sizeof(L3_MODULE) == 256,
+                 "Expected sizeof(L3_MODULE) == 256 bytes.");
+
+static struct
+{
+    L3_EXT      ext;
+    L3_MODULE   modules[L3_MAX_MODULES];
+} l3_crash_modules;
+
+static const int l3_crash_signals[] = { SIGSEGV, SIGABRT, SIGBUS };
+
+#define L3_NUM_CRASH_SIGNALS \
+        (sizeof(l3_crash_signals) / sizeof(*l3_crash_signals))
+
+static struct sigaction l3_crash_oldacts[L3_NUM_CRASH_SIGNALS];
+
+static int      l3_crash_fd = -1;
+static int      l3_crash_dumped = 0;
+static const L3_EXT l3_crash_ext_end = { L3_EXT_END, 0, 0 };
+
+// Handlers run on an alternate stack, to survive stack overflows.
+#define L3_CRASH_STACK_SZ   (64 * 1024)
+
+static char     l3_crash_stack[L3_CRASH_STACK_SZ];
+
+// Alternate stacks of other threads, freed by the key's destructor.
+static pthread_key_t    l3_crash_stack_key;
+static pthread_once_t   l3_crash_stack_once = PTHREAD_ONCE_INIT;
+
+/**
+ * l3_crash_stack_free() - Thread-exit destructor of the alternate stack
+ * installed by l3_crash_thread_init().
+ */
+static void
+l3_crash_stack_free(void *stack)
+{
+    stack_t altstack;
+    memset(&altstack, 0, sizeof(altstack));
+    altstack.ss_flags = SS_DISABLE;
+    sigaltstack(&altstack, NULL);
+    munmap(stack, L3_CRASH_STACK_SZ);
+}
+
+static void
+l3_crash_stack_key_init(void)
+{
+    pthread_key_create(&l3_crash_stack_key, l3_crash_stack_free);
+}
+
+/**
+ * l3_crash_thread_init() - Give the calling thread an alternate stack of
+ * its own, for the crash handlers, unless it has one already. sigaltstack()
+ * only covers the calling thread, so this is done on the 1st log-entry of
+ * each thread, after l3_init_crash_dump(). Best-effort: Without it, a stack
+ * overflow of the thread loses the crash-dump.
+ */
+static void
+l3_crash_thread_init(void)
+{
+    stack_t altstack;
+    if (   (l3_crash_fd == -1)
+        || sigaltstack(NULL, &altstack)
+        || !(altstack.ss_flags & SS_DISABLE)) {
+        return;
+    }
+
+    void *stack = mmap(NULL, L3_CRASH_STACK_SZ, (PROT_READ | PROT_WRITE),
+                       (MAP_PRIVATE | MAP_ANONYMOUS), -1, 0);
+    if (stack == MAP_FAILED) {
+        return;
+    }
+    altstack.ss_sp = stack;
+    altstack.ss_size = L3_CRASH_STACK_SZ;
+    altstack.ss_flags = 0;
+    if (sigaltstack(&altstack, NULL)
+        || pthread_setspecific(l3_crash_stack_key, stack)) {
+        l3_crash_stack_free(stack);
+    }
+}
+
+#if !__APPLE__
+/**
+ * l3_crash_module_cb() - dl_iterate_phdr() callback, to note down the
+ * load-address and path of each module.
+ */
+static int
+l3_crash_module_cb(struct dl_phdr_info *info, size_t size, void *data)
+{
+    (void) size;
+    (void) data;
+
+    uint32_t nmodules = (l3_crash_modules.ext.size / sizeof(L3_MODULE));
+    if (nmodules == L3_MAX_MODULES) {
+        return 1;
+    }
+    L3_MODULE *module = &l3_crash_modules.modules[nmodules];
+    module->base = info->dlpi_addr;
+
+    // The main program is reported with an empty name.
+    if (info->dlpi_name && *info->dlpi_name) {
+        strncpy(module->path, info->dlpi_name, (L3_MODULE_PATH_LEN - 1));
+    } else {
+        ssize_t len = readlink("/proc/self/exe", module->path,
+                               (L3_MODULE_PATH_LEN - 1));
+        module->path[(len > 0) ? len : 0] = '\0';
+    }
+    l3_crash_modules.ext.size += sizeof(L3_MODULE);
+    return 0;
+}
+#endif  // !__APPLE__
+
+/**
+ * l3_crash_handler() - Write the ring to the pre-opened crash-dump file.
+ * Only async-signal-safe calls are made. Then re-raise the signal, with
+ * the previously installed action, so that the process dies as it would
+ * have, e.g. with a core-dump.
+ */
+static void
+l3_crash_handler(int sig, siginfo_t *info, void *ucontext)
+{
+    (void) info;
+    (void) ucontext;
+
+    if (l3_log_ring && !__sync_lock_test_and_set(&l3_crash_dumped, 1)) {
+        struct iovec iov[L3_MAX_CHANNELS + L3_MAX_NUMA_NODES + 3];
+        int iovcnt = 0;
+
+        iov[iovcnt].iov_base = l3_log_ring;
+        iov[iovcnt++].iov_len = l3_ext_base_end_offs;
+
+        if (l3_crash_modules.ext.size) {
+            iov[iovcnt].iov_base = &l3_crash_modules;
+            iov[iovcnt++].iov_len = (sizeof(L3_EXT) + l3_crash_modules.ext.size);
+        }
+
+        // Named channels are mapped separately; The "important" ring is not.
+        for (uint32_t cctr = 0; cctr < l3_nchannels; cctr++) {
+            if (l3_channels[cctr].len) {
+                L3_EXT *ext = ((L3_EXT *) l3_channels[cctr].ring - 1);
+                iov[iovcnt].iov_base = ext;
+                iov[iovcnt++].iov_len = (sizeof(L3_EXT) + ext->size);
+            }
+        }
+        iov[iovcnt].iov_base = (void *) &l3_crash_ext_end;
+        iov[iovcnt++].iov_len = sizeof(l3_crash_ext_end);
+
+        if (writev(l3_crash_fd, iov, iovcnt) > 0) {
+            fsync(l3_crash_fd);
+        }
+    }
+
+    for (uint32_t sctr = 0; sctr < L3_NUM_CRASH_SIGNALS; sctr++) {
+        if (l3_crash_signals[sctr] == sig) {
+            sigaction(sig, &l3_crash_oldacts[sctr], NULL);
+        }
+    }
+    raise(sig);
+}
+
+/**
+ * l3_init_crash_dump() - Pre-open the crash-dump file at 'path' and install
+ * the crash handlers. Expected to be called after l3_init().
+ */
+int
+l3_init_crash_dump(const char *path)
+{
+    if (!path || !l3_log_ring) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    // Create the key of threads' alternate stacks before they look for it.
+    int err = pthread_once(&l3_crash_stack_once, l3_crash_stack_key_init);
+    if (err) {
+        errno = err;
+        return -1;
+    }
+
+    int fd = open(path, (O_WRONLY | O_CREAT | O_TRUNC), 0666);
+    if (fd == -1) {
+        return -1;
+    }
+    if (l3_crash_fd != -1) {
+        close(l3_crash_fd);
+    }
+    l3_crash_fd = fd;
+    l3_crash_dumped = 0;
+
+    memset(&l3_crash_modules, 0, sizeof(l3_crash_modules));
+    l3_crash_modules.ext.type = L3_EXT_MODULES;
+#if !__APPLE__
+    dl_iterate_phdr(l3_crash_module_cb, NULL);
+#endif  // !__APPLE__
+
+    // Other threads get their alternate stacks on their 1st log-entry.
+    stack_t altstack;
+    altstack.ss_sp = l3_crash_stack;
+    altstack.ss_size = sizeof(l3_crash_stack);
+    altstack.ss_flags = 0;
+    if (sigaltstack(&altstack, NULL)) {
+        return -1;
+    }
+
+    struct sigaction act;
+    memset(&act, 0, sizeof(act));
+    act.sa_sigaction = l3_crash_handler;
+    act.sa_flags = (SA_SIGINFO | SA_ONSTACK);
+    sigemptyset(&act.sa_mask);
+
+    for (uint32_t sctr = 0; sctr < L3_NUM_CRASH_SIGNALS; sctr++) {
+        if (sigaction(l3_crash_signals[sctr], &act, &l3_crash_oldacts[sctr])) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * ****************************************************************************
+ * Shared multi-process ring: Cooperating processes attach to one log-file
+ * with l3_init_shared(). The 1st process creates and initializes it as
+ * l3_init() does, with a table of processes appended to its extension
+ * records, and then flags it as shared. Other processes wait for that flag,
+ * and map the log-file as is. Each process claims a slot in the table, and
+ * stashes its slot # in the tid cached by each of its threads, so the logging
+ * fast path is not affected. Threads that logged before l3_init_shared()
+ * keep the tid they cached. All processes log to the one ring, so its entries are globally
+ * ordered.
+ * ****************************************************************************
+ */
+
+/**
+ * l3_proc_register() - Claim a slot in the table of processes.
+ */
+static int
+l3_proc_register(uint64_t fbase_addr, const char *path)
+{
+    uint32_t slot = __sync_fetch_and_add(&l3_procs->nprocs, 1);
+    if (slot >= L3_MAX_PROCS) {
+        errno = ENOSPC;
+        return -1;
+    }
+    L3_PROC *proc = &l3_procs->procs[slot];
+    proc->fbase_addr = fbase_addr;
+    memcpy(proc->path, path, sizeof(proc->path));
+    proc->path[sizeof(proc->path) - 1] = '\0';
+    __sync_synchronize();
+    proc->pid = getpid();
+
+    l3_proc_slot = (slot + 1);
+    l3_my_tid = (L3_GET_TID() | (l3_proc_slot << L3_PROC_SLOT_SHIFT));
+    return 0;
+}
+
+/**
+ * l3_ext_area_attach() - Find the extension records of a shared log-file,
+ * mapped at l3_log, of 'mapsize' bytes.
+ */
+static int
+l3_ext_area_attach(size_t mapsize)
+{
+    char   *end = ((char *) l3_log + mapsize);
+    L3_EXT *ext = (L3_EXT *) (l3_log + 1);
+
+    l3_important = NULL;
+    l3_procs = NULL;
+    while (((char *) (ext + 1) <= end) && (ext->type != L3_EXT_END)) {
+        if ((ext->type == L3_EXT_RING) && !l3_important) {
+            l3_important = (L3_RING *) (ext + 1);
+        } else if (ext->type == L3_EXT_PROCS) {
+            l3_procs = (L3_PROCS *) (ext + 1);
+        }
+        ext = (L3_EXT *) ((char *) (ext + 1) + ext->size);
+    }
+    if (!l3_important || !l3_procs || ((char *) (ext + 1) > end)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    l3_ext_end_offs = ((char *) ext - (char *) l3_log);
+    l3_ext_base_end_offs = l3_ext_end_offs;
+
+    l3_channels[0].ring = l3_important;
+    l3_channels[0].base = NULL;
+    l3_channels[0].len = 0;
+    l3_channels[0].offs = 0;
+    l3_nchannels = 1;
+    return 0;
+}
+
+/**
+ * l3_attach() - Attach to the shared log-file at 'path', once its creator
+ * has initialized it.
+ */
+static int
+l3_attach(const char *path)
+{
+    int fd = open(path, O_RDWR);
+    if (fd == -1) {
+        return -1;
+    }
+
+    L3_LOG *log = MAP_FAILED;
+    struct stat st;
+    for (int tries = 0; tries < 1000; tries++) {
+        if ((log == MAP_FAILED) && !fstat(fd, &st)
+            && ((size_t) st.st_size >= sizeof(L3_LOG))) {
+            log = (L3_LOG *) mmap(NULL, st.st_size, PROT_READ|PROT_WRITE,
+                                  MAP_SHARED, fd, 0);
+        }
+        if ((log != MAP_FAILED)
+            && (__atomic_load_n(&log->flags, __ATOMIC_ACQUIRE) & L3_LOG_FLAG_SHARED)) {
+            break;
+        }
+        struct timespec ts = { 0, 1000000 };
+        nanosleep(&ts, NULL);
+    }
+    if ((log == MAP_FAILED) || !(log->flags & L3_LOG_FLAG_SHARED)) {
+        if (log != MAP_FAILED) {
+            munmap(log, st.st_size);
+        }
+        close(fd);
+        errno = ETIMEDOUT;
+        return -1;
+    }
+
+    // Writers must agree on the layout of log-entries.
+    if ((log->flags & L3_LOG_FLAG_MSGID) != L3_LOG_FLAGS_LAYOUT) {
+        munmap(log, st.st_size);
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+
+    l3_log = log;
+    l3_log_ring = log;
+    l3_log_mapsize = st.st_size;
+    if (l3_log_mmap_fd != -1) {
+        close(l3_log_mmap_fd);
+    }
+    l3_log_mmap_fd = fd;
+    l3_my_tid = L3_GET_TID();
+    l3_atfork_register(path);
+    return l3_ext_area_attach(l3_log_mapsize);
+}
+
+/**
+ * l3_init_shared() - Attach to the log-file at 'path', shared by cooperating
+ * processes, creating it if this is the 1st process to attach.
+ */
+int
+l3_init_shared(const char *path)
+{
+    if (!path) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint64_t fbase_addr = 0;
+    if (l3_fbase_addr(&fbase_addr)) {
+        return -1;
+    }
+
+    char exe[L3_PROC_PATH_LEN] = { '\0' };
+#if !__APPLE__
+    ssize_t len = readlink("/proc/self/exe", exe, (sizeof(exe) - 1));
+    exe[(len > 0) ? len : 0] = '\0';
+#endif  // !__APPLE__
+
+    int creator = 0;
+    int fd = open(path, (O_RDWR | O_CREAT | O_EXCL), 0666);
+    if (fd != -1) {
+        close(fd);
+        l3_log_shared = 1;
+        int rv = l3_init(path);
+        l3_log_shared = 0;
+        if (rv) {
+            return -1;
+        }
+        creator = 1;
+    } else if ((errno != EEXIST) || l3_attach(path)) {
+        return -1;
+    }
+
+    if (l3_proc_register(fbase_addr, exe)) {
+        return -1;
+    }
+    if (creator) {
+        __atomic_fetch_or(&l3_log->flags, L3_LOG_FLAG_SHARED, __ATOMIC_RELEASE);
+    }
+    return 0;
+}
+
+/**
+ * ****************************************************************************
+ * fork()-aware logging: A child created by fork() inherits the parent's
+ * MAP_SHARED ring, and the l3_my_tid cached by the forking thread. The
+ * pthread_atfork() child handler gives the child its own ring, in a log-file
+ * named "<parent's path>.<child's pid>". The file is initialized with a copy
+ * of the parent's mappings, which are then replaced, at the same addresses,
+ * by mappings of the new file. So, l3_log and the handles of channels held
+ * by the program remain valid, and the logging fast path is unaffected.
+ * The child's rings start out empty. In-memory rings are private mappings,
+ * so those are copied-on-write by fork() itself.
+ *
+ * Should the new log-file not be set up, the child is detached from the
+ * parent's rings by remapping them privately, from the parent's log-file, so
+ * that they are copied-on-write, as in-memory rings are. Should that fail
+ * too, the child logs to the scratch ring, which the prepare handler
+ * allocates, leaving the parent's default ring untouched, though not its
+ * other rings, should they still be mapped shared.
+ *
+ * The child of a multi-threaded parent may only make async-signal-safe
+ * calls. mmap() is not one under POSIX, but it is a bare system call, which
+ * takes no locks of the C library, on Linux and on Mac/OSX.
+ * ****************************************************************************
+ */
+
+/**
+ * l3_fork_path() - Format "<l3_log_path>.<pid>" into 'buf' of 'len' bytes.
+ * Returns 0 if it does not fit.
+ */
+static int
+l3_fork_path(char *buf, size_t len, pid_t pid)
+{
+    char digits[16];
+    int ndigits = 0;
+    do {
+        digits[ndigits++] = ('0' + (pid % 10));
+        pid /= 10;
+    } while (pid);
+
+    size_t path_len = strlen(l3_log_path);
+    if ((path_len + 1 + ndigits + 1) > len) {
+        return 0;
+    }
+    memcpy(buf, l3_log_path, path_len);
+    buf[path_len++] = '.';
+    while (ndigits) {
+        buf[path_len++] = digits[--ndigits];
+    }
+    buf[path_len] = '\0';
+    return 1;
+}
+
+/**
+ * l3_fork_remap() - Replace the mappings of the default ring, and of the
+ * channels, at the same addresses, by mappings of the log-file 'fd', shared
+ * or private, per 'flags'. Returns -1 if any of them fails, in which case
+ * the rest may still be the mappings of the parent's log-file.
+ */
+static int
+l3_fork_remap(int fd, int flags)
+{
+    if (mmap(l3_log_ring, l3_log_mapsize, PROT_READ|PROT_WRITE,
+             (flags | MAP_FIXED), fd, 0) == MAP_FAILED) {
+        return -1;
+    }
+    for (uint32_t cctr = 0; cctr < l3_nchannels; cctr++) {
+        L3_CHANNEL_MAP *map = &l3_channels[cctr];
+        if (map->len
+            && (mmap(map->base, map->len, PROT_READ|PROT_WRITE,
+                     (flags | MAP_FIXED), fd, map->offs) == MAP_FAILED)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * l3_fork_file() - Move the child's mappings of the log-file to a new file.
+ * Returns 0 on success; -1 on errors, with the child's rings possibly still
+ * mapping the parent's log-file.
+ */
+static int
+l3_fork_file(void)
+{
+    char path[PATH_MAX];
+    if (!l3_fork_path(path, sizeof(path), getpid())) {
+        return -1;
+    }
+
+    int fd = open(path, (O_RDWR | O_CREAT | O_TRUNC), 0666);
+    if (fd == -1) {
+        return -1;
+    }
+
+    int error = (ftruncate(fd, (l3_ext_end_offs + sizeof(L3_EXT))) != 0);
+    if (!error) {
+        error = (pwrite(fd, l3_log_ring, l3_log_mapsize, 0)
+                    != (ssize_t) l3_log_mapsize);
+    }
+    for (uint32_t cctr = 0; !error && (cctr < l3_nchannels); cctr++) {
+        L3_CHANNEL_MAP *map = &l3_channels[cctr];
+        if (map->len) {
+            error = (pwrite(fd, map->base, map->len, map->offs)
+                        != (ssize_t) map->len);
+        }
+    }
+    if (error || l3_fork_remap(fd, MAP_SHARED)) {
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+    close(l3_log_mmap_fd);
+    l3_log_mmap_fd = fd;
+    return 0;
+}
+
+static void
+l3_atfork_prepare(void)
+{
+    // The child logs to the scratch ring, should it fail to get its own.
+    if (l3_log_ring && (l3_log_mmap_fd != -1)) {
+        l3_scratch_alloc();
+    }
+
+    // Keep the table of channels stable while the child copies it.
+    while (__sync_lock_test_and_set(&l3_channels_lock, 1)) {
+        ;
+    }
+}
+
+static void
+l3_atfork_parent(void)
+{
+    __sync_lock_release(&l3_channels_lock);
+}
+
+static void
+l3_atfork_child(void)
+{
+    l3_my_tid = L3_GET_TID();
+
+    // A child of a process sharing a log-file, shares it too.
+    if (l3_procs && l3_proc_slot) {
+        L3_PROC *parent = &l3_procs->procs[l3_proc_slot - 1];
+        l3_proc_register(parent->fbase_addr, parent->path);
+        __sync_lock_release(&l3_channels_lock);
+        return;
+    }
+
+    if (l3_log_ring) {
+        if (   (l3_log_mmap_fd != -1) && l3_fork_file()
+            && l3_fork_remap(l3_log_mmap_fd, MAP_PRIVATE)) {
+            // Do not rewind, nor thaw, the rings still shared with the parent.
+            if (l3_scratch) {
+                l3_log = l3_scratch;
+            }
+            __sync_lock_release(&l3_channels_lock);
+            return;
+        }
+
+        // Start the child's rings out empty, and not frozen.
+        for (uint32_t cctr = 0; cctr < l3_nchannels; cctr++) {
+            l3_channels[cctr].ring->idx = 0;
+            l3_channels[cctr].ring->freeze_idx = L3_UNFROZEN;
+        }
+        l3_log_ring->idx = 0;
+        l3_log_ring->freeze_idx = L3_UNFROZEN;
+        l3_log = l3_log_ring;
+    }
+    __sync_lock_release(&l3_channels_lock);
+}
+
+/**
+ * l3_sample_rate_refill() - Refill the token-bucket of a L3_SAMPLE_MAX_RATE
+ * call-site, sized to allow a burst of at most 'rate' log-entries.
+ *
+ * Called by l3_log_max_rate() only once the bucket is empty, so the cost of
+ * reading the (coarse) clock is not paid while tokens are available.
+ * Returns non-zero if a token is now available.
+ */
+int
+l3_sample_rate_refill(L3_RATE_STATE *bucket, const uint64_t rate)
+{
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif  // CLOCK_MONOTONIC_COARSE
+
+    uint64_t now_ns = ((ts.tv_sec * 1000000000ULL) + ts.tv_nsec);
+
+    if (bucket->last_ns == 0) {
+        bucket->tokens = rate;      // First call: Start with a full bucket.
+    } else {
+        // An idle second, or more, refills the whole bucket.
+        uint64_t elapsed_ns = L3_MIN((now_ns - bucket->last_ns),
+                                     1000000000ULL);
+        uint64_t ntokens = ((elapsed_ns * rate) / 1000000000ULL);
+        if (ntokens == 0) {
+            return 0;   // Leave last_ns as-is to accumulate elapsed time.
+        }
+        bucket->tokens = L3_MIN(ntokens, rate);
+    }
+    bucket->last_ns = now_ns;
+    return (bucket->tokens != 0);
+}
+
+/**
+ * Per-thread hit-counters of the call-sites described in the 'l3_log_sites'
+ * section, indexed as the descriptors are. Threads' counters are chained,
+ * and never freed, so that hits by threads that have exited are reported.
+ */
+typedef struct l3_site_hits_list
+{
+    struct l3_site_hits_list   *next;
+    uint64_t                    hits[];
+} L3_SITE_HITS;
+
+static L3_SITE_HITS *l3_site_hits_head = NULL;
+static uint64_t      l3_site_hits_start_ns = 0;    // Of the 1st hit
+
+__thread uint64_t *l3_site_hits = NULL;
+
+L3_STATIC_ASSERT(sizeof(L3_SITE) == L3_SITE_ALIGN,
+                 "Expected sizeof(L3_SITE) == L3_SITE_ALIGN.");
+
+/**
+ * ****************************************************************************
+ * l3_nsites() - # of call-sites described in the 'l3_log_sites' section.
+ * ****************************************************************************
+ */
+static size_t
+l3_nsites(void)
+{
+#if __APPLE__
+    return 0;
+#else
+    return (__stop_l3_log_sites - __start_l3_log_sites);
+#endif  // __APPLE__
+}
+
+/**
+ * ****************************************************************************
+ * l3_site_hits_init() - Allocate the calling thread's hit-counters, on the
+ * 1st hit of any call-site by the thread, via L3_SITE_HIT().
+ * Returns NULL if out of memory, leaving the hit uncounted.
+ * ****************************************************************************
+ */
+uint64_t *
+l3_site_hits_init(void)
+{
+    L3_SITE_HITS *thread_hits = calloc(1, (sizeof(L3_SITE_HITS)
+                                           + (l3_nsites() * sizeof(uint64_t))));
+    if (!thread_hits) {
+        return NULL;
+    }
+    uint64_t start_ns = 0;
+    __atomic_compare_exchange_n(&l3_site_hits_start_ns, &start_ns,
+                                l3_clock_ns(CLOCK_MONOTONIC), 0,
+                                __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    do {
+        thread_hits->next = l3_site_hits_head;
+    } while (!__sync_bool_compare_and_swap(&l3_site_hits_head,
+                                           thread_hits->next, thread_hits));
+
+    l3_site_hits = thread_hits->hits;
+    return l3_site_hits;
+}
+
+typedef struct l3_site_stat
+{
+    const L3_SITE  *site;
+    uint64_t        hits;
+} L3_SITE_STAT;
+
+static int
+l3_site_stat_cmp(const void *lhs, const void *rhs)
+{
+    uint64_t lhits = ((const L3_SITE_STAT *) lhs)->hits;
+    uint64_t rhits = ((const L3_SITE_STAT *) rhs)->hits;
+    return ((lhits < rhits) - (lhits > rhits));     // Most hits first
+}
+
+/**
+ * ****************************************************************************
+ * l3_stats() - Print the 'ntop' call-sites with the most hits to 'fh'.
+ *
+ * Counters of other threads are read while they may be counting, so the
+ * report is a near-instantaneous snapshot.
+ * ****************************************************************************
+ */
+int
+l3_stats(FILE *fh, uint32_t ntop)
+{
+    size_t nsites = l3_nsites();
+    L3_SITE_STAT *stats = calloc((nsites ? nsites : 1), sizeof(L3_SITE_STAT));
+    if (!fh || !stats) {
+        free(stats);
+        errno = (fh ? ENOMEM : EINVAL);
+        return -1;
+    }
+
+    uint64_t total = 0;
+    L3_SITE_HITS *head = __atomic_load_n(&l3_site_hits_head, __ATOMIC_ACQUIRE);
+    for (size_t sctr = 0; sctr < nsites; sctr++) {
+#if !__APPLE__
+        stats[sctr].site = &__start_l3_log_sites[sctr];
+#endif  // !__APPLE__
+        for (L3_SITE_HITS *thread_hits = head; thread_hits;
+             thread_hits = thread_hits->next) {
+            stats[sctr].hits += __atomic_load_n(&thread_hits->hits[sctr],
+                                                __ATOMIC_RELAXED);
+        }
+        total += stats[sctr].hits;
+    }
+    qsort(stats, nsites, sizeof(L3_SITE_STAT), l3_site_stat_cmp);
+
+    uint64_t start_ns = __atomic_load_n(&l3_site_hits_start_ns, __ATOMIC_RELAXED);
+    double secs = (start_ns ? ((l3_clock_ns(CLOCK_MONOTONIC) - start_ns) / 1e9)
+                            : 0);
+
+    fprintf(fh, "L3 call-site hits: %" PRIu64 " hits, %zu call-sites, in %.3f s\n",
+            total, nsites, secs);
+    for (size_t sctr = 0; (sctr < L3_MIN(nsites, ntop)) && stats[sctr].hits;
+         sctr++) {
+        const L3_SITE *site = stats[sctr].site;
+        fprintf(fh, "%12" PRIu64 " hits %14.1f /s  %s:%u '%s'\n",
+                stats[sctr].hits, (secs ? (stats[sctr].hits / secs) : 0),
+                site->file, site->line, site->msg);
+    }
+    free(stats);
+    return 0;
 }
 
 /**
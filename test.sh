@@ -112,6 +112,7 @@ TestList=(
 
            # For dev-usage; not invoked thru CI.
            "run-all-client-server-perf-tests"
+           "run-numa-perf-test"
 
            # Collection of individual client-server performance test-methods
            # each invoking different logging schemes, for perf u-benchmarking.
@@ -162,6 +163,10 @@ function usage()
    echo " "
    echo " ./${Me} test-build-and-run-csperf-l3_loc_eq_2 [ server-clock-ID [ num-msgs ] ]"
    echo " "
+   echo "Compare logging to the default ring vs. to the rings of NUMA nodes:"
+   echo " "
+   echo " ./${Me} run-numa-perf-test [ num-million-msgs [ num-threads ] ]"
+   echo " "
    echo "Environment Variables:"
    echo "   L3_PERF_SERVER_NUM_THREADS: List of server-threads to exercise; e.g. \"1 2 4\""
    echo "   L3_PERF_TEST_NUM_ITERS: Number of iterations to perform test."
@@ -516,6 +521,36 @@ function run-all-client-server-perf-tests()
     echo " "
 }
 
+# #############################################################################
+# Run the benchmark of logging from a thread per CPU, to the default ring vs.
+# to the rings of the threads' NUMA nodes. The win shows on multi-node hosts,
+# or on kernels booted with numa=fake=<N>. Run this under, e.g.,
+# `numactl --cpunodebind=0,1 ./test.sh run-numa-perf-test` to select nodes.
+#
+# Parameters:
+#   $1  - (Opt) # of million messages to log from each thread (default: 1)
+#   $2  - (Opt) # of threads (default: one per CPU)
+# #############################################################################
+function run-numa-perf-test()
+{
+    set +x
+    if [ "${UNAME_S}" = "Darwin" ]; then
+        echo "${Me}: NUMA-aware rings not supported on Mac/OSX."
+        return
+    fi
+
+    if command -v numactl > /dev/null 2>&1; then
+        numactl --hardware
+    fi
+
+    set -x
+    make clean
+    CC=gcc LD=g++ make all-unit-tests
+
+    "./build/${Build_mode}/bin/unit/l3-numa-perf-test" "$@"
+    set +x
+}
+
 # #############################################################################
 # Test build-and-run of client-server performance test benchmark.
 # This test-case runs with no-L3-logging (baseline).
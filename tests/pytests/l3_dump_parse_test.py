@@ -8,6 +8,11 @@ logic parsing `readelf` output works correctly.
 """
 import os
 import sys
+import struct
+import subprocess
+import time
+import re
+import uuid
 
 # #############################################################################
 # Full dir-path where this tests/ dir lives
@@ -279,3 +284,351 @@ def pr_debug_info(ro_data:str, string_offs:dict, exp_hash:dict):
     print("\nActual string-offsets:\n")
     for offset in string_offs.keys():
         print(f"{offset=} -> {string_offs[offset]}")
+
+# #############################################################################
+def test_sample_extrapolate():
+    """
+    Exercise estimation of # of executions of sampled call-sites.
+    """
+    assert l3_dump.sample_extrapolate(l3_dump.L3_SAMPLE_EVERY_N, 0, 100, 10) == 1000
+    assert l3_dump.sample_extrapolate(l3_dump.L3_SAMPLE_FIRST_K, 3, 10, 2) == 2
+    assert l3_dump.sample_extrapolate(l3_dump.L3_SAMPLE_FIRST_K, 3, 10, 13) == 103
+    assert l3_dump.sample_extrapolate(l3_dump.L3_SAMPLE_MAX_RATE, 0, 5, 5) == 5
+
+# #############################################################################
+def test_typed_args():
+    """
+    Exercise decoding of the raw bits of arguments logged by l3::log<>(),
+    by their types.
+    """
+    double_bits = struct.unpack('<Q', struct.pack('<d', -2.5))[0]
+    assert l3_dump.typed_args((l3_dump.L3_ARG_DOUBLE, l3_dump.L3_ARG_INT),
+                              double_bits, (1 << 64) - 7) == (-2.5, -7)
+    assert l3_dump.typed_args((l3_dump.L3_ARG_UINT, l3_dump.L3_ARG_CHAR),
+                              (1 << 64) - 1, (1 << 64) - 0xbf) == ((1 << 64) - 1, 0x41)
+    assert l3_dump.typed_args((l3_dump.L3_ARG_PTR, l3_dump.L3_ARG_NONE),
+                              0xdeadbeef, 0) == (0xdeadbeef,)
+    assert l3_dump.typed_args((l3_dump.L3_ARG_NONE, l3_dump.L3_ARG_NONE), 0, 0) == ()
+
+# #############################################################################
+def test_str_continuation_entries(tmp_path):
+    """
+    Exercise unpacking of the default ring, where l3_log_str() logged a
+    string into an entry and its continuation entries, identified by ~tid.
+    The continuation entry in the oldest slot lost its entry, so is skipped.
+    """
+    tid = 1234
+    msgptr = 0x1000
+    string = b'client-0123456789abcdefghijklmnopqrstuvwxyz'
+    slots = [ struct.pack('<i28s', ~tid, b'lost'),
+              struct.pack('<iiQQ8s', tid, 0, msgptr, len(string), string[:8]),
+              struct.pack('<i28s', ~tid, string[8:36]),
+              struct.pack('<i28s', ~tid, string[36:]),
+              struct.pack('<iiQQQ', tid, 0, msgptr + 8, 1, 2) ]
+    logfile = tmp_path / 'l3.str-test.dat'
+    logfile.write_bytes(bytes(l3_dump.L3_LOG_HEADER_SZ) + b''.join(slots))
+
+    with open(logfile, 'rb') as file:
+        entries = list(l3_dump.l3_unpack_default_ring(file, len(slots), len(slots)))
+    assert [entry[0][0] for entry in entries] == [1, 4]
+
+    (_, _, _, _, arg1, arg2) = entries[0][1]
+    assert arg2[:len(string)] == string
+    assert l3_dump.typed_args((l3_dump.L3_ARG_STR, l3_dump.L3_ARG_NONE),
+                              arg1, arg2) == (string.decode(),)
+    assert l3_dump.str_arg(3, int.from_bytes(b'abc', 'little')) == 'abc'
+    assert entries[1][1][4:] == (1, 2)
+
+# #############################################################################
+def test_bytes_arg_and_blob_decoders():
+    """
+    Exercise splitting the data logged by l3_log_bytes() into its tag and
+    buffer, and decoding buffers by registered decoders, else by hexdump.
+    """
+    tagptr = 0x2000
+    blob = bytes(range(10))
+    data = tagptr.to_bytes(8, 'little') + blob + bytes(18)
+    assert l3_dump.bytes_arg(len(blob), data) == (tagptr, blob)
+    assert l3_dump.bytes_arg(0, tagptr) == (tagptr, b'')
+
+    assert l3_dump.blob_decode('parse-test', b'\x01\xab') == 'parse-test[2]: 01 ab'
+    l3_dump.register_blob_decoder('parse-test', lambda blob: f"len={len(blob)}")
+    l3_dump.register_blob_decoder('parse-test-fails', lambda blob: blob[8])
+    try:
+        assert l3_dump.blob_decode('parse-test', blob) == 'len=10'
+        assert l3_dump.blob_decode('parse-test-fails', b'\x01') == 'parse-test-fails[1]: 01'
+    finally:
+        del l3_dump.L3_BLOB_DECODERS['parse-test']
+        del l3_dump.L3_BLOB_DECODERS['parse-test-fails']
+
+# #############################################################################
+def test_fmtstr_annotations_and_dwarf_enums():
+    """
+    Exercise parsing of the annotations of arguments in format strings, and
+    of the enums, and typedefs of them, in `readelf --debug-dump=info` output.
+    """
+    assert l3_dump.fmtstr_annotations('id=%d, arg2=%d') == ('id=%d, arg2=%d', ())
+    assert l3_dump.fmtstr_annotations('100%% state=%lu{enum:state_t} e=%d{errno}') \
+                == ('100%% state=%s e=%s', ('enum:state_t', 'errno'))
+    assert l3_dump.fmtstr_annotations('p=%p, e=%-4d{errno}') \
+                == ('p=%p, e=%s', (None, 'errno'))
+
+    readelf_out = """
+ <1><2d>: Abbrev Number: 2 (DW_TAG_enumeration_type)
+    <2e>   DW_AT_name        : (indirect string, offset: 0x10): state
+    <32>   DW_AT_byte_size   : 4
+ <2><36>: Abbrev Number: 3 (DW_TAG_enumerator)
+    <37>   DW_AT_name        : (indirect string, offset: 0x20): ST_IDLE
+    <3b>   DW_AT_const_value : 0
+ <2><3c>: Abbrev Number: 4 (DW_TAG_enumerator)
+    <3d>   DW_AT_name        : ST_FAILED
+    <41>   DW_AT_const_value : -1
+ <2><42>: Abbrev Number: 0
+ <1><43>: Abbrev Number: 5 (DW_TAG_typedef)
+    <44>   DW_AT_name        : (indirect string, offset: 0x30): state_t
+    <48>   DW_AT_type        : <0x2d>
+ <1><4c>: Abbrev Number: 5 (DW_TAG_typedef)
+    <4d>   DW_AT_name        : (indirect string, offset: 0x40): my_state_t
+    <51>   DW_AT_type        : <0x43>
+ <1><55>: Abbrev Number: 6 (DW_TAG_base_type)
+    <56>   DW_AT_name        : (indirect string, offset: 0x50): int
+"""
+    enum_types = l3_dump.parse_dwarf_enums(readelf_out)
+    states = {0: 'ST_IDLE', -1: 'ST_FAILED'}
+    assert enum_types == {'state': states, 'state_t': states, 'my_state_t': states}
+
+    assert l3_dump.annotated_arg('enum:state_t', (1 << 64) - 1, enum_types) == 'ST_FAILED'
+    assert l3_dump.annotated_arg('enum:state_t', 7, enum_types) == '7'
+    assert l3_dump.annotated_arg('enum:unknown_t', 0, enum_types) == '0'
+    assert l3_dump.annotated_arg('errno', 2, enum_types) == 'ENOENT'
+
+# #############################################################################
+def ctf_read(ctf_dir) -> (list, int):
+    """
+    Read back the events of a CTF trace exported by l3_dump.py, by the layout
+    of its stream, and the event classes described by its metadata.
+
+    Returns: Tuple: (list of events: (name, timestamp, pid, tid, fields),
+                     # of packets)
+    """
+    metadata = (ctf_dir / 'metadata').read_text()
+    assert metadata.startswith('/* CTF 1.8 */')
+    trace_uuid = re.search(r'uuid = "([-0-9a-f]+)";', metadata).group(1)
+    tsdl_fmts = { 'int64_t': 'q', 'uint64_t': 'Q', 'uint64x_t': 'Q', 'double': 'd' }
+    classes = {}
+    for match in re.finditer(r'event \{\n    name = "((?:[^"\\]|\\.)*)";\n'
+                             + r'    id = (\d+);\n    stream_id = 0;\n'
+                             + r'    fields := struct \{([^}]*)\};', metadata):
+        types = [line.split()[0] for line in match.group(3).strip().splitlines()]
+        classes[int(match.group(2))] = (match.group(1), types)
+
+    events = []
+    npackets = 0
+    data = (ctf_dir / 'stream_0').read_bytes()
+    offset = 0
+    while offset < len(data):
+        (magic, pkt_uuid, stream_id) = struct.unpack_from('<I16sI', data, offset)
+        assert (magic, str(uuid.UUID(bytes=pkt_uuid)), stream_id) \
+                == (l3_dump.CTF_MAGIC, trace_uuid, 0)
+        (time_begin, time_end, content_size, packet_size) \
+            = struct.unpack_from('<QQQQ', data, offset + 24)
+        assert content_size == packet_size
+        end = offset + (packet_size // 8)
+        offset += 56
+        packet_times = []
+        while offset < end:
+            (class_id, timestamp, pid, tid) = struct.unpack_from('<IQii', data, offset)
+            offset += struct.calcsize('<IQii')
+            (name, types) = classes[class_id]
+            fields = []
+            for ftype in types:
+                if ftype == 'string':
+                    nul = data.index(b'\0', offset)
+                    fields.append(data[offset:nul].decode())
+                    offset = nul + 1
+                else:
+                    fields.append(struct.unpack_from('<' + tsdl_fmts[ftype], data, offset)[0])
+                    offset += 8
+            events.append((name, timestamp, pid, tid, tuple(fields)))
+            packet_times.append(timestamp)
+        assert offset == end
+        assert (time_begin, time_end) == (packet_times[0], packet_times[-1])
+        npackets += 1
+    return (events, npackets)
+
+# #############################################################################
+def test_ctf_export(tmp_path, monkeypatch):
+    """
+    Exercise the export of log-entries as a CTF trace: The fields of event
+    classes by the types described by call-sites, else by the conversions
+    of the format strings, and their streaming in packets.
+    """
+    assert l3_dump.ctf_event_args('a=%d, b=%p', (), (1 << 64) - 2, 0x1000, None, {}) \
+            == (('int64', 'hex64'), (-2, 0x1000))
+    assert l3_dump.ctf_event_args('errno=%d{errno}, 100%%', (), 2, 0, None, {}) \
+            == (('string',), ('ENOENT',))
+    assert l3_dump.ctf_event_args("name='%s'", (l3_dump.L3_ARG_STR, l3_dump.L3_ARG_NONE),
+                                  3, 'abc', None, {}) == (('string',), ('abc',))
+    assert l3_dump.ctf_event_args('x=%g', (l3_dump.L3_ARG_DOUBLE, l3_dump.L3_ARG_NONE),
+                                  0x3ff8000000000000, 0, None, {}) == (('double',), (1.5,))
+    assert l3_dump.ctf_tsdl_string('say "hi"\n') == '"say \\"hi\\"\\n"'
+
+    monkeypatch.setattr(l3_dump, 'CTF_PACKET_SIZE', 100)
+    ctf = l3_dump.ctf_open(str(tmp_path))
+    for ictr in range(10):
+        l3_dump.ctf_log_entry(ctf, 1000 + ictr, 42, 43, 'Msg: ictr=%d, arg2=%u',
+                              ('int64', 'uint64'), (ictr - 5, ictr))
+    l3_dump.ctf_log_entry(ctf, 2000, 42, 44, 'Say "%s"', ('string',), ('hello',))
+    l3_dump.ctf_close(ctf)
+
+    (events, npackets) = ctf_read(tmp_path)
+    assert npackets > 1
+    assert len(events) == 11
+    assert events[3] == ('Msg: ictr=%d, arg2=%u', 1003, 42, 43, (-2, 3))
+    assert events[-1] == ('Say \\"%s\\"', 2000, 42, 44, ('hello',))
+
+# #############################################################################
+def test_merge_logs_by_time():
+    """
+    Exercise the k-way merge of log-entries from several log-files by the
+    wall-clock time derived from each file's clock anchor. Entries without a
+    timestamp retain their order within their log-file.
+    """
+    # Log-file 0: 1 tick / ns, anchored at 1000 ns. Log-file 1: 2 ticks / ns.
+    log0 = [((0, 0, 110), 'a'), ((1, 1, 0), 'b'), ((1, 0, 130), 'c')]
+    log1 = [((0, 0, 40), 'x'), ((0, 0, 70), 'y')]
+    timeline0 = l3_dump.l3_timeline(log0, (100, 1000, 1000000000))
+    timeline1 = l3_dump.l3_timeline(log1, (0, 1000, 2000000000))
+
+    merged = list(l3_dump.l3_merge_logs([timeline0, timeline1]))
+    assert merged == [(1010, 0, 'a'), (1010, 0, 'b'), (1020, 1, 'x'),
+                      (1030, 0, 'c'), (1035, 1, 'y')]
+
+# #############################################################################
+def test_trace_span_phase():
+    """
+    Exercise classification of messages as beginning or ending a duration
+    slice of trace-events exported by the dumper.
+    """
+    assert l3_dump.trace_span_phase('Begin request id=%d, arg2=%d') == ('B', 'request id=%d, arg2=%d')
+    assert l3_dump.trace_span_phase('end: request id=%d, arg2=%d') == ('E', 'request id=%d, arg2=%d')
+    assert l3_dump.trace_span_phase('Beginning id=%d, arg2=%d') == ('i', 'Beginning id=%d, arg2=%d')
+    assert l3_dump.trace_span_phase('End') == ('i', 'End')
+
+# #############################################################################
+def test_span_msg_parse_and_percentile():
+    """
+    Exercise identification of the log-entries of spans, and the percentiles
+    of span durations reported by the dumper.
+    """
+    assert l3_dump.span_msg_parse('Begin commit: span=%lu, tsc=%lu') == (True, 'commit')
+    assert l3_dump.span_msg_parse('End commit: span=%llu, tsc=%llu') == (False, 'commit')
+    assert l3_dump.span_msg_parse('Begin commit id=%d, arg2=%d') is None
+
+    durations = list(range(1, 1001))
+    assert l3_dump.span_percentile(durations, 50) == 500
+    assert l3_dump.span_percentile(durations, 99) == 990
+    assert l3_dump.span_percentile(durations, 99.9) == 999
+    assert l3_dump.span_percentile([7], 99.9) == 7
+
+# #############################################################################
+def test_cpu_migrated(capsys):
+    """
+    Exercise detection of threads migrating between CPUs across their
+    consecutive log-entries, and the per-CPU report of the dumper.
+    """
+    last_cpus = {}
+    assert l3_dump.cpu_migrated(last_cpus, (0, 0, 100), 2) is None
+    assert l3_dump.cpu_migrated(last_cpus, (0, 0, 200), 5) is None
+    assert l3_dump.cpu_migrated(last_cpus, (0, 0, 100), 2) is None
+    assert l3_dump.cpu_migrated(last_cpus, (0, 0, 100), 3) == 2
+    assert l3_dump.cpu_migrated(last_cpus, (0, 0, 200), 5) is None
+    assert l3_dump.cpu_migrated(last_cpus, (0, 0, 100), 2) == 3
+
+    # The same tid in another log-file is another thread.
+    assert l3_dump.cpu_migrated(last_cpus, (1, 0, 100), 7) is None
+
+    # Entries of tid 0 may be of any thread, so are not tracked.
+    assert l3_dump.cpu_migrated(last_cpus, (0, 0, 0), 2) is None
+    assert l3_dump.cpu_migrated(last_cpus, (0, 0, 0), 3) is None
+    assert (0, 0, 0) not in last_cpus
+
+    l3_dump.cpu_report({ 3: ["tid=100 'b'"], 2: ["tid=100 'a'", "tid=200 'c'"] },
+                       { (0, 0, 100): 2 })
+    assert capsys.readouterr().out.splitlines() \
+            == [ "CPU 2: 2 log-entries", "    tid=100 'a'", "    tid=200 'c'",
+                 "CPU 3: 1 log-entries", "    tid=100 'b'",
+                 "Thread tid=100: 2 migrations between CPUs." ]
+
+# #############################################################################
+def test_l3_numa_node():
+    """
+    Exercise l3_numa_node(), which maps the rings of NUMA nodes to the node,
+    only in L3-log files written after l3_init_numa().
+    """
+    assert l3_dump.l3_numa_node('numa0', True) == 0
+    assert l3_dump.l3_numa_node('numa12', True) == 12
+    assert l3_dump.l3_numa_node('numa0', False) is None
+    assert l3_dump.l3_numa_node('numa', True) is None
+    assert l3_dump.l3_numa_node('numa-net', True) is None
+    assert l3_dump.l3_numa_node('important', True) is None
+
+# #############################################################################
+def test_unpack_strings():
+    """
+    Exercise unpacking of the format strings copied into the log-file, as a
+    sequence of L3_STRING{}s, each followed by its padded string.
+    """
+    payload = (  struct.pack('<QII', 0x1000, 32, 9) + b'msg=%d %d'.ljust(16, b'\0')
+               + struct.pack('<QII', 0x2000, 24, 0) + b''.ljust(8, b'\0'))
+    exts = [(l3_dump.L3_EXT_CLOCK, bytes(32)), (l3_dump.L3_EXT_STRINGS, payload)]
+    assert l3_dump.l3_unpack_strings(exts) == { 0x1000: 'msg=%d %d', 0x2000: '' }
+
+# #############################################################################
+# Benchmark decoding of LOC-IDs of this many distinct call-sites.
+LOC_BENCH_NFILES        = 100
+LOC_BENCH_NLINES        = 100
+LOC_BENCH_NEXECS        = 50
+
+def test_loc_decode_benchmark(tmp_path):
+    """
+    Build a stand-in LOC-decoder binary, with a loc_filenames[] table, as the
+    LOC-generator does. Verify that LOC-IDs of 10K distinct call-sites are
+    decoded by table lookup, and compare against exec'ing the LOC-decoder
+    binary for each LOC-ID.
+    """
+    filenames = [f"dir/file-{fctr}.c" for fctr in range(LOC_BENCH_NFILES)]
+    decoder_src = tmp_path / 'bench_loc.c'
+    decoder_src.write_text(
+          '#include <stdio.h>\n#include <stdlib.h>\n'
+        + 'const char *loc_filenames[] = {\n'
+        + ''.join(f'    "{name}",\n' for name in filenames)
+        + '};\n'
+        + 'int main(int argc, char **argv) {\n'
+        + '    unsigned loc = strtoul(argv[2], NULL, 10);\n'
+        + '    printf("%s:%u\\n", loc_filenames[loc >> 16], loc & 0xffff);\n'
+        + '    return 0;\n}\n')
+    decoder_bin = str(tmp_path / 'bench_loc')
+    assert subprocess.run(['gcc', '-o', decoder_bin, str(decoder_src)],
+                          check=False).returncode == 0
+
+    locs = [(fctr << 16) | lctr for fctr in range(LOC_BENCH_NFILES)
+                                for lctr in range(1, LOC_BENCH_NLINES + 1)]
+
+    start = time.perf_counter()
+    loc_decoders = {}
+    for loc in locs:
+        unpacked = l3_dump.loc_decode(loc_decoders, decoder_bin, loc)
+        assert unpacked == f"{filenames[loc >> 16]}:{loc & 0xffff}"
+    lookup_secs = time.perf_counter() - start
+    assert loc_decoders[decoder_bin]['filenames'] == filenames
+
+    start = time.perf_counter()
+    for loc in locs[:LOC_BENCH_NEXECS]:
+        assert l3_dump.exec_binary([decoder_bin, '--brief', str(loc)]) \
+               == f"{filenames[loc >> 16]}:{loc & 0xffff}"
+    exec_secs = (time.perf_counter() - start) * len(locs) / LOC_BENCH_NEXECS
+
+    print(f"Decoded {len(locs)} distinct LOC-IDs in {lookup_secs:.3f} s,"
+          + f" v/s ~{exec_secs:.3f} s exec'ing the LOC-decoder for each.")
+    assert lookup_secs < exec_secs
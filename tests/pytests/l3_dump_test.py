@@ -13,6 +13,10 @@ import sys
 import platform
 import subprocess as sp
 import shlex
+import shutil
+import json
+import struct
+import pytest
 from fnmatch import fnmatchcase
 # DEBUG: from pprint import pprint
 
@@ -54,6 +58,8 @@ L3_DUMP_ARG_BINARY   = '--binary'
 L3_LOC_UNSET            = "0"
 L3_LOC_DEFAULT          = "1"
 L3_LOC_ELF_ENCODING     = "2"
+L3_LOC_RETADDR          = "3"
+L3_LOC_CPUID            = "4"
 
 # Ternary: variable = something if condition else something_else
 # BUILD_MODE = os.getenv(BUILD_MODE) if BUILD_MODE in os.environ else 'release'
@@ -177,6 +183,625 @@ def test_unit_test_dump_log_entries():
     # Unit-tests are currently not enabled to run with LOC_ENABLED env-var
     assert verify_loc_field_is_empty(loc_list) is True
 
+# #############################################################################
+@pytest.fixture(scope='module', name='binary')
+def fixture_l3_dump_py_test() -> str:
+    """
+    Build and run the l3_dump.py-test unit-test once, for all the test-cases
+    below which only unpack the dump files it creates. Return the path of the
+    unit-test binary, to unpack those files against.
+    """
+    make_rv = exec_make(['make', 'clean'])
+    make_rv = exec_make(['make', 'all-unit-tests'],
+                        { "BUILD_VERBOSE": "1", "CC": "g++", "CXX": "g++", "LD": "g++" })
+    assert make_rv is True
+
+    binary = L3RootDir + '/build/' + BUILD_MODE + '/bin/unit/l3_dump.py-test'
+    exec_rv = exec_binary(binary)
+    assert exec_rv is True
+    return binary
+
+# #############################################################################
+def test_unit_test_dump_sampled_log_entries(binary):
+    """
+    Build and run the unit-test, which will also create a dump file with
+    log-entries from sampled call-sites. Verify that only the sampled calls
+    were logged and that l3_dump.py recovers each site's sampling policy.
+    """
+    l3_dump_dat = '/tmp/l3.c-sample-unit-test.dat'
+    (nentries, tid_list, loc_list, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, l3_dump_dat,
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+
+    exp_arg1_list = (  list(range(0, 1000, 100))
+                     + [0, 1, 2] + list(range(3, 100, 10))
+                     + list(range(0, 5)))
+    assert arg1_list == exp_arg1_list
+
+    verify_rv = verify_output_lists(nentries, len(exp_arg1_list),
+                                    tid_list, loc_list,
+                                    msg_list,
+                                    arg1_list, arg2_list)
+    assert verify_rv is True
+
+    # Verify the sampling policies recorded for each of the 3 call-sites.
+    with open(l3_dump_dat, 'rb') as file:
+        (_, log_size) = l3_dump.l3_unpack_logsize(file)
+        exts = l3_dump.l3_unpack_exts(file, log_size)
+
+    policies = sorted(l3_dump.l3_unpack_sample_sites(exts).values())
+    assert policies == [ (l3_dump.L3_SAMPLE_EVERY_N, 0, 100),
+                         (l3_dump.L3_SAMPLE_FIRST_K, 3, 10),
+                         (l3_dump.L3_SAMPLE_MAX_RATE, 0, 5) ]
+
+# #############################################################################
+def test_unit_test_dump_important_log_entries(binary):
+    """
+    Build and run the unit-test, which will also create a dump file where
+    a flood of debug log-entries wraps the default ring-buffer. Verify that
+    the high-severity entries survive in the ring of important entries and
+    that l3_dump.py merges them chronologically with the default ring.
+    """
+    l3_dump_dat = '/tmp/l3.c-important-unit-test.dat'
+    (nentries, tid_list, loc_list, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, l3_dump_dat,
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+
+    # Default ring retains the last L3_MAX_SLOTS of the 16484 debug entries.
+    nslots = 16384
+    nflood = nslots + 100
+    exp_arg1_list = ([0]
+                     + list(range(nflood - nslots, nslots + 50))
+                     + [nslots + 50]
+                     + list(range(nslots + 50, nflood)))
+    assert arg1_list == exp_arg1_list
+
+    verify_rv = verify_output_lists(nentries, len(exp_arg1_list),
+                                    tid_list, loc_list,
+                                    msg_list,
+                                    arg1_list, arg2_list)
+    assert verify_rv is True
+
+    assert msg_list[0] == 'Important-log-msg: error, ictr=0, arg2=1'
+    assert msg_list[nslots - 49] == f'Important-log-msg: warning, ictr={nslots + 50}, arg2=1'
+
+# #############################################################################
+def test_unit_test_dump_channel_log_entries(binary):
+    """
+    Build and run the unit-test, which will also create a dump file with
+    log-entries logged to named channels. Verify that l3_dump.py lists the
+    channels, merges their entries chronologically, and filters by name.
+    """
+    l3_dump_dat = '/tmp/l3.c-channel-unit-test.dat'
+    with open(l3_dump_dat, 'rb') as file:
+        (idx, log_size) = l3_dump.l3_unpack_logsize(file)
+        exts = l3_dump.l3_unpack_exts(file, log_size)
+
+    assert l3_dump.l3_list_channels(idx, log_size, exts) \
+                == [ ('default', 16384, 10), ('important', 1024, 0),
+                     ('net', 128, 200), ('storage', 16, 5) ]
+
+    # Replay the order of log-entries as logged by the unit-test.
+    # Channel 'net' retains only its last 128 entries.
+    exp_entries = []
+    for ictr in range(200):
+        if ictr >= (200 - 128):
+            exp_entries.append(('net', ictr))
+        if (ictr % 20) == 0:
+            exp_entries.append(('default', ictr))
+        if (ictr % 40) == 0:
+            exp_entries.append(('storage', ictr))
+
+    for channels in [ None, ['net'], ['default', 'storage'] ]:
+        args = [L3_DUMP_ARG_LOG_FILE, l3_dump_dat, L3_DUMP_ARG_BINARY, binary]
+        for name in (channels or []):
+            args += ['--channel', name]
+
+        (nentries, tid_list, loc_list, msg_list, arg1_list, arg2_list) \
+            = l3_dump.do_main(args, return_logentry_lists = True)
+
+        exp_msg_list = [f'Channel-log-msg: {name}, ictr={ictr}, arg2=' +
+                        {'net': '0', 'default': '1', 'storage': '2'}[name]
+                        for (name, ictr) in exp_entries
+                        if channels is None or name in channels]
+        assert msg_list == exp_msg_list
+
+        verify_rv = verify_output_lists(nentries, len(exp_msg_list),
+                                        tid_list, loc_list,
+                                        msg_list,
+                                        arg1_list, arg2_list)
+        assert verify_rv is True
+
+# #############################################################################
+def test_unit_test_dump_frozen_log_entries(binary):
+    """
+    Build and run the unit-test, which will also create a dump file with
+    log-entries from a ring frozen by l3_freeze_after(), and then thawed.
+    Verify that exactly the window of entries up to the freeze is retained.
+    """
+    l3_dump_dat = '/tmp/l3.c-freeze-unit-test.dat'
+    (nentries, tid_list, loc_list, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, l3_dump_dat,
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+
+    exp_arg1_list = (  list(range(0, 56)) + [55] + list(range(56, 60))
+                     + [100, 101, 101, 102])
+    exp_arg2_list = (  [0] * 56 + [1] + [0] * 4
+                     + [0, 0, 1, 0])
+    assert arg1_list == exp_arg1_list
+    assert arg2_list == exp_arg2_list
+
+    verify_rv = verify_output_lists(nentries, len(exp_arg1_list),
+                                    tid_list, loc_list,
+                                    msg_list,
+                                    arg1_list, arg2_list)
+    assert verify_rv is True
+
+# #############################################################################
+def test_unit_test_dump_crash_log_entries(binary):
+    """
+    Build and run the unit-test, which crashes child processes logging to an
+    in-memory ring, and so creates crash-dump files. Verify that l3_dump.py
+    unpacks the crash-dump like a L3-log file, with its module map, also for
+    a stack overflow in a thread.
+    """
+    l3_dump_dat = '/tmp/l3.c-crash-unit-test.dat'
+    (nentries, tid_list, loc_list, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, l3_dump_dat,
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+
+    exp_arg1_list = [ictr for ictr in range(10) for _ in range(2)]
+    assert arg1_list == exp_arg1_list
+    assert arg2_list == [0, 1] * 10
+
+    verify_rv = verify_output_lists(nentries, len(exp_arg1_list),
+                                    tid_list, loc_list,
+                                    msg_list,
+                                    arg1_list, arg2_list)
+    assert verify_rv is True
+
+    with open(l3_dump_dat, 'rb') as file:
+        (_, log_size) = l3_dump.l3_unpack_logsize(file)
+        exts = l3_dump.l3_unpack_exts(file, log_size)
+
+    modules = [path for (_, path) in l3_dump.l3_unpack_modules(exts)]
+    assert os.path.realpath(binary) in modules
+
+    # A stack overflow in a thread, other than the one that installed the
+    # crash handlers, is dumped on the thread's own alternate stack.
+    (nentries, tid_list, loc_list, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-crash-thread-unit-test.dat',
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+
+    assert arg1_list == [0, 1, 2]
+    assert arg2_list == [2, 2, 2]
+
+    verify_rv = verify_output_lists(nentries, 3,
+                                    tid_list, loc_list,
+                                    msg_list,
+                                    arg1_list, arg2_list)
+    assert verify_rv is True
+
+# #############################################################################
+def test_unit_test_dump_core_log_entries(binary):
+    """
+    Build and run the unit-test, which crashes a child process logging to an
+    in-memory ring, so that it dumps core. Verify that l3_dump.py extracts
+    the ring, and named channels, from the core file.
+    """
+    core_dir = '/tmp/l3.c-core-unit-test'
+    cores = [core_dir + '/' + name for name in os.listdir(core_dir)
+             if name.startswith('core')]
+    if not cores:
+        pytest.skip(f"Core file was not dumped in {core_dir}.")
+
+    (nentries, tid_list, loc_list, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main(['--core-file', max(cores, key=os.path.getmtime),
+                           L3_DUMP_ARG_BINARY, binary],
+                          return_logentry_lists = True)
+
+    exp_arg1_list = [ictr for ictr in range(10) for _ in range(2)]
+    assert arg1_list == exp_arg1_list
+    assert arg2_list == [0, 1] * 10
+
+    verify_rv = verify_output_lists(nentries, len(exp_arg1_list),
+                                    tid_list, loc_list,
+                                    msg_list,
+                                    arg1_list, arg2_list)
+    assert verify_rv is True
+
+# #############################################################################
+def test_unit_test_dump_fork_log_entries(binary):
+    """
+    Build and run the unit-test, which forks a child process after L3-logging
+    is initialized. Verify that the parent and child log to their own rings,
+    the child's being in a log-file named after the parent's, and its pid.
+    """
+    l3_dump_dat = '/tmp/l3.c-fork-unit-test.dat'
+    (nentries, tid_list, loc_list, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, l3_dump_dat,
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+    assert arg2_list == [0, 0]
+    verify_rv = verify_output_lists(nentries, 2, tid_list, loc_list, msg_list,
+                                    arg1_list, arg2_list)
+    assert verify_rv is True
+
+    # The parent logged the child's pid, to find the child's log-file.
+    child_pid = arg1_list[1]
+    (nentries, tid_list, loc_list, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, f'{l3_dump_dat}.{child_pid}',
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+    assert arg1_list == [0, 0, 1, 1, 2, 2]
+    assert arg2_list == [1, 2] * 3
+
+    # The child's tid is its pid, as the child is single-threaded.
+    verify_rv = verify_output_lists(nentries, 6, tid_list, loc_list, msg_list,
+                                    arg1_list, arg2_list)
+    assert verify_rv is True
+    assert tid_list[0] == child_pid
+
+    # The child, failing to create its log-file, logged to private copies of
+    # the parent's rings, leaving the parent's default ring and channel, and
+    # its important ring, as they were.
+    l3_dump_dat = '/tmp/l3.c-fork-fail-unit-test.dat'
+    (nentries, _, _, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, l3_dump_dat,
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+    assert nentries == 5
+    assert arg2_list == [0, 2, 0, 0, 2]
+    assert msg_list[:3] == [ 'Fork-fail-log-msg: parent, ictr=0, arg2=0'
+                           , 'Fork-fail-log-msg: parent net, ictr=0, arg2=2'
+                           , 'Fork-fail-log-msg: parent, ictr=1, arg2=0' ]
+    assert msg_list[4] == 'Fork-fail-log-msg: parent net, ictr=1, arg2=2'
+    assert not os.path.exists(f'{l3_dump_dat}.{arg1_list[3]}')
+
+# #############################################################################
+def test_unit_test_dump_shared_log_entries(binary):
+    """
+    Build and run the unit-test, which creates a log-file shared across
+    processes, with l3_init_shared(), and forks a child that logs to it.
+    Verify that the entries of both processes are interleaved in the order
+    they were logged, each tagged with the pid of the process that logged it.
+    """
+    l3_dump_dat = '/tmp/l3.c-shared-unit-test.dat'
+    (nentries, tid_list, loc_list, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, l3_dump_dat,
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+    assert nentries == 8
+    assert arg1_list[:7] == [0, 0, 1, 2, 3, 4, 5]
+    assert arg2_list == [0, 1, 1, 1, 1, 1, 1, 0]
+    assert msg_list[0] == 'Shared-log-msg: parent, ictr=0, arg2=0'
+    assert msg_list[4] == 'Shared-log-msg: child attached, ictr=3, arg2=1'
+    assert msg_list[6] == 'Shared-log-msg: child thread, ictr=5, arg2=1'
+
+    # The main thread's tid is that process' pid.
+    child_pid = arg1_list[7]
+    assert tid_list[0] == tid_list[7]
+    assert tid_list[1:5] == [child_pid] * 4
+    assert child_pid != tid_list[0]
+
+    # The child's thread, which first logged after the child attached, logs
+    # its own tid, and is tagged with the child's pid.
+    assert tid_list[5] == tid_list[6]
+    assert tid_list[5] not in (0, child_pid, tid_list[0])
+
+# #############################################################################
+def test_unit_test_dump_merge_log_entries(binary, capsys):
+    """
+    Build and run the unit-test, in which a parent and a child process take
+    turns logging to their own log-files. Verify that merging both log-files
+    by time interleaves their log-entries in the order they were logged, and
+    warns of default rings without timestamps, which cannot be interleaved.
+    """
+    (nentries, tid_list, loc_list, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-merge-unit-test.dat',
+                           L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-merge-child-unit-test.dat',
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+    assert nentries == 8
+    assert arg1_list == list(range(8))
+    assert arg2_list == [0, 1] * 4
+    assert msg_list[1] == 'Merge-log-msg: child, ictr=1, arg2=1'
+    assert tid_list[0::2] == [tid_list[0]] * 4
+    assert tid_list[1::2] == [tid_list[1]] * 4
+    assert 'Warning' not in capsys.readouterr().err
+
+    # Without L3_MSGID_ENABLED, entries of the default rings are stamped with
+    # the time of l3_init() of their log-file.
+    (nentries, _, _, _, arg1_list, _) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-merge-default-unit-test.dat',
+                           L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-merge-default-child-unit-test.dat',
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+    assert nentries == 8
+    assert arg1_list != list(range(8))
+    warnings = capsys.readouterr().err.splitlines()
+    assert len(warnings) == 2
+    assert 'l3.c-merge-default-unit-test.dat have no timestamps' in warnings[0]
+
+# #############################################################################
+def test_unit_test_dump_trace_export(binary, capsys):
+    """
+    Build and run the unit-test, which logs Begin / End pairs of messages.
+    Export the log-entries as Chrome JSON trace-events, and verify that the
+    pairs become duration slices, around instant events, on the thread's track.
+    Without L3_MSGID_ENABLED, expect a warning that they are not timestamped.
+    """
+    trace_file = '/tmp/l3.c-trace-unit-test.json'
+    (nentries, _, _, _, _, _) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-trace-unit-test.dat',
+                           L3_DUMP_ARG_BINARY,   binary,
+                           '--trace-file',       trace_file])
+    assert nentries == 9
+    assert 'l3.c-trace-unit-test.dat have no timestamps' in capsys.readouterr().err
+
+    with open(trace_file, 'r', encoding='utf-8') as file:
+        events = json.load(file)['traceEvents']
+
+    assert events[0]['ph'] == 'M'
+    events = events[1:]
+    assert [event['ph'] for event in events] == ['B', 'i', 'E'] * 3
+    assert events[0]['name'] == 'trace-request id=%d, arg2=%d'
+    assert events[0]['args']['msg'] == 'Begin trace-request id=0, arg2=0'
+    assert events[4]['name'] == 'Trace-log-msg: processing, ictr=1, arg2=1'
+
+    # Events on the thread's track are in time-order.
+    assert len({event['tid'] for event in events}) == 1
+    times = [event['ts'] for event in events]
+    assert times == sorted(times)
+
+# #############################################################################
+def test_unit_test_dump_spans(binary, capsys):
+    """
+    Build and run the unit-test, which logs nested spans, and one that does not
+    end. Verify the latencies reported per span name, and the unmatched span.
+    """
+    capsys.readouterr()
+    (nentries, _, _, msg_list, _, _) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-span-unit-test.dat',
+                           L3_DUMP_ARG_BINARY,   binary,
+                           '--spans'],
+                          return_logentry_lists = True)
+    assert nentries == 303
+    assert msg_list[0].startswith('Begin outer: span=')
+
+    report = capsys.readouterr().out.splitlines()
+    assert report[1].startswith("Span 'inner': 100 spans, p50=")
+    assert "Span 'outer': 1 spans, p50=" in '\n'.join(report)
+    assert report[-1].startswith("Unmatched span 'unended': not ended,")
+
+# #############################################################################
+def test_unit_test_dump_str_log_entries(binary):
+    """
+    Build and run the unit-test, which logs strings of several lengths by
+    l3_log_str(). Verify that the strings are gathered from the entries'
+    continuation entries, and truncated to L3_LOG_STR_MAX bytes.
+    """
+    (nentries, tid_list, _, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-str-unit-test.dat',
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+
+    names = [ '', 'abc', '12345678',
+              'queue-0123456789abcdef',
+              'client-0123456789abcdefghijklmnopqrstuvwxyz',
+              'file-0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNO' ]
+    assert nentries == (2 * len(names)) + 1
+    assert len(set(tid_list)) == 1
+    for (ictr, name) in enumerate(names):
+        assert msg_list[2 * ictr] == f"Str-log-msg: name='{name}'"
+        assert arg1_list[2 * ictr] == len(name)
+        assert arg2_list[2 * ictr] == name
+        assert msg_list[(2 * ictr) + 1] == f"Str-log-msg: ictr={ictr}, arg2=0"
+    assert msg_list[-1] == f"Str-log-msg: dynamic name='pid-{tid_list[0]}'"
+
+# #############################################################################
+def test_unit_test_dump_bytes_log_entries(binary):
+    """
+    Build and run the unit-test, which logs buffers by l3_log_bytes(). Verify
+    that buffers are decoded by the decoders of a plugin file, else hexdumped,
+    and truncated to L3_LOG_BYTES_MAX bytes.
+    """
+    decoders = L3RootDir + '/use-cases/client-server-msgs-perf/svmsg_decoders.py'
+    (nentries, _, _, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-bytes-unit-test.dat',
+                           L3_DUMP_ARG_BINARY,   binary,
+                           '--decoders',         decoders],
+                          return_logentry_lists = True)
+
+    assert nentries == 4
+    assert msg_list[0] == ('Bytes-log-msg: req: mtype=REQ_MT_INCR, clientId=42,'
+                           + ' client_idx=7, counter=1000')
+    assert arg1_list[0] == 24
+    assert msg_list[1] == 'Bytes-log-msg: buf: buffer[3]: 00 01 02'
+    assert arg1_list[2] == 128
+    assert arg2_list[2] == ('buffer[128]: '
+                            + ' '.join(f"{byte:02x}" for byte in range(128)))
+    assert msg_list[3] == 'Bytes-log-msg: ictr=1, arg2=2'
+
+# #############################################################################
+def test_unit_test_dump_enum_log_entries(binary):
+    """
+    Build and run the unit-test, which logs arguments annotated as enums and
+    errnos. Verify that they are decoded into their names, the enums' from
+    the binary's DWARF. Without the binary, enums are printed as integers.
+    """
+    (nentries, _, _, msg_list, _, _) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-enum-unit-test.dat',
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+
+    states = ['TEST_L3_IDLE', 'TEST_L3_BUSY', 'TEST_L3_DONE', 'TEST_L3_FAILED', '5']
+    assert nentries == len(states) + 1
+    for (ictr, state) in enumerate(states):
+        assert msg_list[ictr] == f"Enum-log-msg: ictr={ictr}, state={state}"
+    assert msg_list[-1] == 'Enum-log-msg: state=TEST_L3_BUSY, errno=ENOENT'
+
+    (_, _, _, msg_list, _, _) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-enum-unit-test.dat'],
+                          return_logentry_lists = True)
+    assert msg_list[-1] == 'Enum-log-msg: state=1, errno=ENOENT'
+
+# #############################################################################
+def test_unit_test_dump_numa_log_entries(binary):
+    """
+    Build and run the unit-test, which logs to the rings of NUMA nodes, after
+    l3_init_numa(), from the main thread and another thread. Verify that the
+    node's ring is merged chronologically with the default ring, where
+    strings are logged, and with the ring of important entries.
+    """
+    l3_dump_dat = '/tmp/l3.c-numa-unit-test.dat'
+    with open(l3_dump_dat, 'rb') as file:
+        assert l3_dump.l3_unpack_logflags(file) & l3_dump.L3_LOG_FLAG_NUMA
+        (idx, log_size) = l3_dump.l3_unpack_logsize(file)
+        exts = l3_dump.l3_unpack_exts(file, log_size)
+
+    # Rings of all online nodes are opened by l3_init_numa(), followed by the
+    # named channels, which the rings do not take up.
+    channels = l3_dump.l3_list_channels(idx, log_size, exts)
+    assert channels[:2] == [ ('default', 16384, 2), ('important', 1024, 1) ]
+    nodes = [name for (name, _, _) in channels
+             if l3_dump.l3_numa_node(name, True) is not None]
+    assert nodes == [name for (name, _, _) in channels[2:(2 + len(nodes))]]
+    assert sum(nentries for (_, _, nentries) in channels[2:(2 + len(nodes))]) == 9
+    assert [name for (name, _, _) in channels[(2 + len(nodes)):]] \
+                == [f'ch{cctr}' for cctr in range(1, 16)]
+
+    exp_msg_list = ([f'NUMA-log-msg: {"fast" if (ictr % 2) else "slow"}, '
+                     f'ictr={ictr}, arg2=0' for ictr in range(4)]
+                    + ['NUMA-log-msg: str=default-ring']
+                    + [f'NUMA-log-msg: {"fast" if (ictr % 2) else "slow"}, '
+                       f'ictr={ictr}, arg2=0' for ictr in range(4, 6)]
+                    + [f'NUMA-log-msg: thread, ictr={ictr}, arg2=2'
+                       for ictr in range(6, 8)]
+                    + ['NUMA-log-msg: important, ictr=8, arg2=1']
+                    + ['NUMA-log-msg: channels opened, ictr=9, arg2=0'])
+
+    (nentries, _, _, msg_list, _, _) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, l3_dump_dat,
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+    assert nentries == len(exp_msg_list)
+    assert msg_list == exp_msg_list
+
+    # The rings of nodes stand in for the default ring.
+    (nentries, _, _, msg_list, _, _) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, l3_dump_dat,
+                           L3_DUMP_ARG_BINARY,   binary,
+                           '--channel', 'default'],
+                          return_logentry_lists = True)
+    assert msg_list == exp_msg_list[:-2] + exp_msg_list[-1:]
+
+    # Once re-initialized by l3_init(), threads log to the default ring.
+    l3_dump_dat = '/tmp/l3.c-numa-off-unit-test.dat'
+    with open(l3_dump_dat, 'rb') as file:
+        assert not l3_dump.l3_unpack_logflags(file) & l3_dump.L3_LOG_FLAG_NUMA
+        (idx, log_size) = l3_dump.l3_unpack_logsize(file)
+        exts = l3_dump.l3_unpack_exts(file, log_size)
+    assert l3_dump.l3_list_channels(idx, log_size, exts) \
+                == [ ('default', 16384, 2), ('important', 1024, 0) ]
+
+    (nentries, _, _, msg_list, _, _) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, l3_dump_dat,
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+    assert msg_list == ['NUMA-log-msg: slow, ictr=10, arg2=0',
+                        'NUMA-log-msg: fast, ictr=11, arg2=0']
+
+# #############################################################################
+def test_unit_test_dump_ctf_export(binary, tmp_path):
+    """
+    Build and run the unit-test, which logs strings, and enums. Export its
+    log-entries as CTF traces. Verify that each message is described as an
+    event class, with fields of the types of its arguments, and that the
+    stream is made up of whole packets.
+    """
+    for (name, exp_nclasses, exp_fields) in \
+            [('str', 3, ['string arg1;', 'int64_t arg1;\n        int64_t arg2;']),
+             ('enum', 2, ['int64_t arg1;\n        string arg2;',
+                          'string arg1;\n        string arg2;'])]:
+        ctf_dir = tmp_path / name
+        (nentries, _, _, _, _, _) \
+            = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, f"/tmp/l3.c-{name}-unit-test.dat",
+                               L3_DUMP_ARG_BINARY,   binary,
+                               '--ctf-dir',          str(ctf_dir)],
+                              return_logentry_lists = True)
+        assert nentries > 0
+
+        metadata = (ctf_dir / 'metadata').read_text()
+        assert metadata.startswith('/* CTF 1.8 */')
+        assert metadata.count('\nevent {') == exp_nclasses
+        for fields in exp_fields:
+            assert f"fields := struct {{\n        {fields}\n    }};" in metadata
+
+        # Walk the packets of the stream, counting the events of each.
+        data = (ctf_dir / 'stream_0').read_bytes()
+        assert len(data) > 0
+        offset = 0
+        while offset < len(data):
+            (magic, _, _, _, _, _, packet_size) \
+                = struct.unpack_from('<I16sIQQQQ', data, offset)
+            assert magic == l3_dump.CTF_MAGIC
+            offset += packet_size // 8
+        assert offset == len(data)
+
+# #############################################################################
+@pytest.mark.skipif(shutil.which('babeltrace2') is None, reason="babeltrace2 is not installed")
+def test_unit_test_dump_ctf_export_babeltrace2(binary, tmp_path):
+    """
+    Build and run the unit-test, which logs strings, and enums. Export its
+    log-entries as CTF traces, and read them back with babeltrace2, to verify
+    that the TSDL metadata is valid and describes every event of the stream.
+    """
+    for (name, exp_field) in [('str', 'arg1 = "abc"'), ('enum', '_vtid = ')]:
+        ctf_dir = tmp_path / name
+        (nentries, _, _, _, _, _) \
+            = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, f"/tmp/l3.c-{name}-unit-test.dat",
+                               L3_DUMP_ARG_BINARY,   binary,
+                               '--ctf-dir',          str(ctf_dir)],
+                              return_logentry_lists = True)
+
+        result = sp.run(['babeltrace2', str(ctf_dir)], text=True,
+                        capture_output=True, check=False)
+        print(result.stdout, result.stderr)
+        assert result.returncode == 0
+        assert result.stdout.count('_vtid = ') == nentries
+        assert exp_field in result.stdout
+
+# #############################################################################
+def test_unit_test_dump_without_binary(binary):
+    """
+    Build and run the unit-test, which will also create dump files. Verify
+    that the format strings copied into the log-files decode log-entries,
+    from all rings, as the program binary does, without the binary.
+    """
+    for l3_dump_dat in ['/tmp/l3.c-small-unit-test.dat',
+                        '/tmp/l3.c-channel-unit-test.dat',
+                        '/tmp/l3.c-span-unit-test.dat',
+                        '/tmp/l3.c-str-unit-test.dat',
+                        '/tmp/l3.c-bytes-unit-test.dat']:
+        with open(l3_dump_dat, 'rb') as file:
+            (_, log_size) = l3_dump.l3_unpack_logsize(file)
+            exts = l3_dump.l3_unpack_exts(file, log_size)
+        assert len(l3_dump.l3_unpack_strings(exts)) > 0
+
+        lists = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, l3_dump_dat],
+                                return_logentry_lists = True)
+        exp_lists = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, l3_dump_dat,
+                                     L3_DUMP_ARG_BINARY,   binary],
+                                    return_logentry_lists = True)
+        assert lists[0] > 0
+        assert lists == exp_lists
+
 # #############################################################################
 def test_c_test_dump_log_entries():
     """
@@ -259,6 +884,234 @@ def test_cc_test_dump_log_entries():
                                       usecase_prog_dir, 'test-main.cc')
     assert unpack_rv is True
 
+# #############################################################################
+def test_typed_cpp20_program_dump_log_entries():
+    """
+    Build and run the C++20 typed front end sample program. Invoke the L3-dump
+    utility. Verify that arguments are decoded by their types, as described
+    by the call-sites of l3::log<>(), and that call-sites of l3_log_srcloc()
+    are located by their source locations.
+    """
+    make_rv = exec_make(['make', 'clean'])
+    make_rv = exec_make(['make', 'typed-cpp20-program'],
+                        { "BUILD_VERBOSE": "1",
+                          "CC": "gcc", "CXX": "g++", "LD": "g++",
+                        } )
+    assert make_rv is True
+
+    binary = L3RootDir + '/build/' + BUILD_MODE + '/bin/use-cases/' \
+           + 'typed-Cpp20-program'
+
+    print(f"Exec {binary=} ...")
+    exec_rv = exec_binary([binary])
+    assert exec_rv is True
+
+    (nentries, _, loc_list, msg_list, _, _) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, '/tmp/l3.typed-cpp20-test.dat',
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+
+    assert nentries == 8
+    assert msg_list == [ 'Elapsed 2.5 secs, delta=-42',
+                         'Read 18446744073709551615 bytes, ratio=-0.125',
+                         "Grade 'A', at addr=0xdeadbeef",
+                         'Color=-2, valid=1',
+                         '100% of {braces} are literal',
+                         'Source-location iteration 0',
+                         'Source-location iteration 1',
+                         'Source-location done, ratio=0.5' ]
+
+    # Lines, and columns, of the call-sites of l3_log_srcloc().
+    src_file = 'use-cases/typed-Cpp20-program/test-main.cpp'
+    src_locs = []
+    with open(L3RootDir + '/' + src_file, encoding='utf-8') as src:
+        for (lineno, line) in enumerate(src, start=1):
+            if line.lstrip().startswith('l3_log_srcloc('):
+                column = line.index('l3_log_srcloc(') + 1
+                src_locs.append(f"{src_file}:{lineno}:{column}"
+                                + ' void log_src_locs(int)')
+    assert len(src_locs) == 2
+    assert loc_list == ([''] * 5) + [src_locs[0], src_locs[0], src_locs[1]]
+
+# #############################################################################
+def test_c_test_dump_log_entries_loc_retaddr():
+    """
+    Build and run the C-sample-programs to generate small # of log-entries,
+    with L3_LOC_RETADDR=1. Invoke the L3-dump utility. Verify that the
+    return addresses logged are symbolized to the lines of the call-sites.
+    """
+    make_rv = exec_make(['make', 'clean'])
+
+    make_rv = exec_make(['make', 'all-c-tests'],
+                        { "BUILD_VERBOSE": "1",
+                          "CC": "gcc", "CXX": "g++", "LD": "g++",
+                          "L3_LOC_RETADDR": "1"} )
+    assert make_rv is True
+
+    # Execute the C-sample program test binary built above.
+    usecase_prog_dir = 'single-file-C-program'
+    binary = L3RootDir + '/build/' + BUILD_MODE + '/bin/use-cases/' \
+           + usecase_prog_dir
+
+    print(f"Exec {binary=} --unit-tests ...")
+    exec_rv = exec_binary([binary, '--unit-tests'])
+    assert exec_rv is True
+
+    unpack_rv = verify_l3_dump_unpack('/tmp/l3.c-small-test.dat',
+                                      L3_LOC_RETADDR, binary,
+                                      usecase_prog_dir, 'test-main.c')
+    assert unpack_rv is True
+
+# #############################################################################
+def test_c_test_dump_log_entries_msgid():
+    """
+    Build and run the C-sample-programs to generate small # of log-entries,
+    with L3_MSGID_ENABLED=1. Invoke the L3-dump utility. Verify that the
+    message ids logged are resolved to their msgs, and that the entries of
+    the default ring are timestamped, in the order they were logged.
+    """
+    make_rv = exec_make(['make', 'clean'])
+
+    make_rv = exec_make(['make', 'all-c-tests'],
+                        { "BUILD_VERBOSE": "1",
+                          "CC": "gcc", "CXX": "g++", "LD": "g++",
+                          "L3_MSGID_ENABLED": "1"} )
+    assert make_rv is True
+
+    # Execute the C-sample program test binary built above.
+    usecase_prog_dir = 'single-file-C-program'
+    binary = L3RootDir + '/build/' + BUILD_MODE + '/bin/use-cases/' \
+           + usecase_prog_dir
+
+    print(f"Exec {binary=} --unit-tests ...")
+    exec_rv = exec_binary([binary, '--unit-tests'])
+    assert exec_rv is True
+
+    unpack_rv = verify_l3_dump_unpack('/tmp/l3.c-small-test.dat',
+                                      L3_LOC_UNSET, binary,
+                                      usecase_prog_dir, 'test-main.c')
+    assert unpack_rv is True
+
+    log = l3_dump.l3_load_log('/tmp/l3.c-small-test.dat', None, binary, None)
+    assert log['msgids'] is True
+    tscs = [tsc for ((_, _, tsc), _) in log['entries']]
+    assert len(tscs) == 5
+    assert 0 not in tscs
+    assert tscs == sorted(tscs)
+
+# #############################################################################
+def test_unit_test_dump_merge_log_entries_msgid(capsys):
+    """
+    Build and run the unit-test with L3_MSGID_ENABLED=1, in which a parent and
+    a child process take turns logging to the default ring of their own
+    log-files. Verify that the timestamps of the entries of the default rings
+    interleave them, when merging both log-files.
+    """
+    make_rv = exec_make(['make', 'clean'])
+    make_rv = exec_make(['make', 'all-unit-tests'],
+                        { "BUILD_VERBOSE": "1", "CC": "g++", "CXX": "g++", "LD": "g++",
+                          "L3_MSGID_ENABLED": "1" })
+    assert make_rv is True
+
+    binary = L3RootDir + '/build/' + BUILD_MODE + '/bin/unit/l3_dump.py-test'
+    exec_rv = exec_binary(binary)
+    assert exec_rv is True
+    capsys.readouterr()
+
+    (nentries, tid_list, _, msg_list, arg1_list, arg2_list) \
+        = l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-merge-default-unit-test.dat',
+                           L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-merge-default-child-unit-test.dat',
+                           L3_DUMP_ARG_BINARY,   binary],
+                          return_logentry_lists = True)
+    assert nentries == 8
+    assert arg1_list == list(range(8))
+    assert arg2_list == [0, 1] * 4
+    assert msg_list[1] == 'Merge-log-msg: child, ictr=1, arg2=1'
+    assert tid_list[0::2] == [tid_list[0]] * 4
+    assert tid_list[1::2] == [tid_list[1]] * 4
+    assert 'Warning' not in capsys.readouterr().err
+
+# #############################################################################
+@pytest.mark.skipif(OS_UNAME_S != 'Linux', reason="L3_CPUID_ENABLED is not supported on Mac/OSX")
+def test_c_test_dump_log_entries_cpuid(capsys):
+    """
+    Build and run the C-sample-programs to generate small # of log-entries,
+    with L3_CPUID_ENABLED=1. Invoke the L3-dump utility. Verify that each
+    log-entry, also those logged by l3_log_fast(), reports a valid CPU, and
+    that --per-cpu groups all the log-entries by their CPU.
+    """
+    make_rv = exec_make(['make', 'clean'])
+
+    make_rv = exec_make(['make', 'all-c-tests'],
+                        { "BUILD_VERBOSE": "1",
+                          "CC": "gcc", "CXX": "g++", "LD": "g++",
+                          "L3_CPUID_ENABLED": "1"} )
+    assert make_rv is True
+
+    # Execute the C-sample program test binary built above.
+    usecase_prog_dir = 'single-file-C-program'
+    binary = L3RootDir + '/build/' + BUILD_MODE + '/bin/use-cases/' \
+           + usecase_prog_dir
+
+    print(f"Exec {binary=} --unit-tests ...")
+    exec_rv = exec_binary([binary, '--unit-tests'])
+    assert exec_rv is True
+
+    unpack_rv = verify_l3_dump_unpack('/tmp/l3.c-small-test.dat',
+                                      L3_LOC_CPUID, binary,
+                                      usecase_prog_dir, 'test-main.c')
+    assert unpack_rv is True
+
+    capsys.readouterr()
+    l3_dump.do_main([L3_DUMP_ARG_LOG_FILE, '/tmp/l3.c-small-test.dat',
+                     L3_DUMP_ARG_BINARY, binary, '--per-cpu'])
+    ncpu_entries = [int(line.split()[2])
+                    for line in capsys.readouterr().out.splitlines()
+                    if line.startswith('CPU ')]
+    assert sum(ncpu_entries) == 5
+
+# #############################################################################
+@pytest.mark.skipif(OS_UNAME_S != 'Linux', reason="USDT probes are not supported on Mac/OSX")
+def test_c_test_dump_log_entries_usdt():
+    """
+    Build and run the C-sample-programs to generate small # of log-entries,
+    with L3_USDT_ENABLED=1. Verify that each l3_log() / l3_log_fast() call-site
+    emits its probe note, with its 3 operands, and that the L3-dump utility
+    unpacks the log-entries as without the probes.
+    """
+    make_rv = exec_make(['make', 'clean'])
+
+    make_rv = exec_make(['make', 'all-c-tests'],
+                        { "BUILD_VERBOSE": "1",
+                          "CC": "gcc", "CXX": "g++", "LD": "g++",
+                          "L3_USDT_ENABLED": "1"} )
+    assert make_rv is True
+
+    # Execute the C-sample program test binary built above.
+    usecase_prog_dir = 'single-file-C-program'
+    binary = L3RootDir + '/build/' + BUILD_MODE + '/bin/use-cases/' \
+           + usecase_prog_dir
+
+    print(f"Exec {binary=} --unit-tests ...")
+    exec_rv = exec_binary([binary, '--unit-tests'])
+    assert exec_rv is True
+
+    unpack_rv = verify_l3_dump_unpack('/tmp/l3.c-small-test.dat',
+                                      L3_LOC_UNSET, binary,
+                                      usecase_prog_dir, 'test-main.c')
+    assert unpack_rv is True
+
+    notes = sp.run(['readelf', '-n', binary], stdout=sp.PIPE, text=True,
+                   check=True).stdout
+    probes = [line.split()[-1] for line in notes.splitlines()
+              if line.strip().startswith('Name: log')]
+    assert probes.count('log') >= 4
+    assert probes.count('log_fast') >= 3
+    assert notes.count('Provider: l3') == len(probes)
+    for line in notes.splitlines():
+        if line.strip().startswith('Arguments:'):
+            assert len(line.split()) == 4
+
 # #############################################################################
 def test_c_test_dump_log_entries_loc_eq_1():
     """
@@ -478,6 +1331,16 @@ def verify_l3_dump_unpack(l3_dump_dat:str,
     # LOC-ID will be unpacked only if LOC was generated at logging-time
     if decode_loc_id == int(L3_LOC_DEFAULT):
         assert loc_list == exp_loc_list
+    elif decode_loc_id == int(L3_LOC_RETADDR):
+        # Return addresses symbolize to 'function+offset path/file:line'
+        for (loc, exp_loc) in zip(loc_list, exp_loc_list):
+            assert loc.startswith('main+0x')
+            assert loc.endswith('/' + exp_loc)
+    elif decode_loc_id == int(L3_LOC_CPUID):
+        # Each entry reports the CPU it was logged on.
+        for loc in loc_list:
+            assert loc.startswith('cpu=')
+            assert 0 <= int(loc[len('cpu='):]) < os.cpu_count()
     else:
         assert verify_loc_field_is_empty(loc_list) is True
 
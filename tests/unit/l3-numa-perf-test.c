@@ -0,0 +1,201 @@
+/**
+ * *****************************************************************************
+ * \file l3-numa-perf-test.c
+ * \brief L3: Lightweight Logging Library NUMA-aware rings performance Unit-test
+ * \version 0.1
+ * \date 2024-05-29
+ *
+ * \copyright Copyright (c) 2024
+ *
+ * Usage: program-name [ <number-of-million-msgs> [ <number-of-threads> ] ]
+ *  Default, log 1 million messages from each of one thread per CPU, first to
+ *  the default ring, i.e. l3_init(), and then to the rings of the threads'
+ *  NUMA nodes, i.e. l3_init_numa(), and compare the logging throughput.
+ *
+ *  Threads are pinned to the CPUs the program may run on, in turn. So, run
+ *  it under `numactl --cpunodebind=<nodes>` to select the NUMA nodes.
+ * *****************************************************************************
+ */
+#include <stdlib.h>
+#include <time.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <glob.h>
+
+#include "l3.h"
+#include "l3-perf-test.h"
+
+#if !__APPLE__
+
+typedef struct numa_perf_thread
+{
+    pthread_t           thread;
+    int                 cpu;
+    uint32_t            nmsgs;
+    pthread_barrier_t  *start;
+} NUMA_PERF_THREAD;
+
+static uint64_t test_numa_logging_perf(const char *ringtype, int numa,
+                                       int nMil, int nthreads);
+static void *test_numa_logging_thread(void *arg);
+static int test_numa_nodes(void);
+
+/**
+ * *****************************************************************************
+ * The L3 logging-APIs are exercised from several threads, logging to one
+ * ring, and then to one ring per NUMA node, to measure the cost of threads on
+ * different nodes contending for the ring's idx, and storing to slots on a
+ * remote node. The win is only seen on hosts with several NUMA nodes, e.g.
+ * 2-socket machines, or kernels booted with numa=fake=<N>.
+ * *****************************************************************************
+ */
+int
+main(const int argc, const char * argv[])
+{
+    int nMil = 1;
+    if (argc > 1) {
+        nMil = atoi(argv[1]);
+    }
+
+    cpu_set_t cpus;
+    if (sched_getaffinity(0, sizeof(cpus), &cpus)) {
+        abort();
+    }
+    int nthreads = CPU_COUNT(&cpus);
+    if (argc > 2) {
+        nthreads = atoi(argv[2]);
+    }
+    printf("%d threads, on %d CPUs of %d NUMA node(s):\n",
+           nthreads, CPU_COUNT(&cpus), test_numa_nodes());
+
+    // Warm-up
+    test_numa_logging_perf("default", 0, 1, nthreads);
+
+    uint64_t ns_default = test_numa_logging_perf("default", 0, nMil, nthreads);
+    uint64_t ns_numa = test_numa_logging_perf("NUMA", 1, nMil, nthreads);
+
+    printf("NUMA rings: %.2fx the throughput of the default ring.\n",
+           ((double) ns_default / ns_numa));
+    return 0;
+}
+
+/**
+ * *****************************************************************************
+ * test_numa_logging_perf() - Log 'nMil' million msgs from each of 'nthreads'
+ * threads, to the default ring, or to the rings of NUMA nodes if 'numa'.
+ * Returns the elapsed ns.
+ * *****************************************************************************
+ */
+static uint64_t
+test_numa_logging_perf(const char *ringtype, int numa, int nMil, int nthreads)
+{
+    const char *logfile = (numa ? "/tmp/l3-numa-perf-test-numa.dat"
+                                : "/tmp/l3-numa-perf-test-default.dat");
+    int e = (numa ? l3_init_numa(logfile) : l3_init(logfile));
+    if (e) {
+        abort();
+    }
+
+    cpu_set_t cpus;
+    if (sched_getaffinity(0, sizeof(cpus), &cpus)) {
+        abort();
+    }
+
+    pthread_barrier_t start;
+    if (pthread_barrier_init(&start, NULL, (nthreads + 1))) {
+        abort();
+    }
+
+    NUMA_PERF_THREAD *threads = calloc(nthreads, sizeof(*threads));
+    if (!threads) {
+        abort();
+    }
+    int cpu = -1;
+    for (int tctr = 0; tctr < nthreads; tctr++) {
+        // Pin threads to the CPUs we may run on, in turn.
+        do {
+            cpu = ((cpu + 1) % CPU_SETSIZE);
+        } while (!CPU_ISSET(cpu, &cpus));
+
+        threads[tctr].cpu = cpu;
+        threads[tctr].nmsgs = (nMil * L3_MILLION);
+        threads[tctr].start = &start;
+        if (pthread_create(&threads[tctr].thread, NULL,
+                           test_numa_logging_thread, &threads[tctr])) {
+            abort();
+        }
+    }
+
+    struct timespec ts0;
+    struct timespec ts1;
+    pthread_barrier_wait(&start);
+    if (clock_gettime(CLOCK_REALTIME, &ts0)) {
+        abort();
+    }
+    for (int tctr = 0; tctr < nthreads; tctr++) {
+        pthread_join(threads[tctr].thread, NULL);
+    }
+    if (clock_gettime(CLOCK_REALTIME, &ts1)) {
+        abort();
+    }
+    uint64_t nsec = (timespec_to_ns(&ts1) - timespec_to_ns(&ts0));
+
+    free(threads);
+    pthread_barrier_destroy(&start);
+    l3_log_deinit(L3_LOG_MMAP);
+
+    uint64_t nmsgs = ((uint64_t) nthreads * nMil * L3_MILLION);
+    printf("%d Mil %s ring log msgs/thread: %" PRIu64 " ns/msg (avg),"
+           " %.1f Mil msgs/sec: %s\n",
+           nMil, ringtype, ((nsec * nthreads) / nmsgs),
+           ((double) nmsgs * 1000 / nsec), logfile);
+    return nsec;
+}
+
+static void *
+test_numa_logging_thread(void *arg)
+{
+    NUMA_PERF_THREAD *self = (NUMA_PERF_THREAD *) arg;
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(self->cpu, &cpus);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) {
+        abort();
+    }
+    pthread_barrier_wait(self->start);
+
+    for (uint32_t n = 0; n < self->nmsgs; n++) {
+        l3_log("Perf-l3-log msgs, ctr=%d, cpu=%d\n", n, self->cpu);
+    }
+    return NULL;
+}
+
+/**
+ * test_numa_nodes() - # of NUMA nodes of the host, as listed in sysfs.
+ */
+static int
+test_numa_nodes(void)
+{
+    glob_t nodes;
+    if (glob("/sys/devices/system/node/node[0-9]*", 0, NULL, &nodes)) {
+        return 1;
+    }
+    int nnodes = (int) nodes.gl_pathc;
+    globfree(&nodes);
+    return nnodes;
+}
+
+#else   // !__APPLE__
+
+int
+main(const int argc, const char * argv[])
+{
+    printf("NUMA-aware rings are not supported on Mac/OSX.\n");
+    return 0;
+}
+
+#endif  // !__APPLE__
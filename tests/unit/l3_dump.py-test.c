@@ -23,18 +23,73 @@
 #include <time.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
 
 #include "l3.h"
 
+// Decoded by its name, from the binary's DWARF, by l3_dump.py.
+typedef enum test_l3_state {
+    TEST_L3_IDLE = 0,
+    TEST_L3_BUSY,
+    TEST_L3_DONE = 10,
+    TEST_L3_FAILED = -1
+} test_l3_state_t;
+
 // Function prototypes
 void test_l3_slow_log(void);
 void test_l3_fast_log(void);
+void test_l3_sampled_log(void);
+void test_l3_important_log(void);
+void test_l3_channel_log(void);
+void test_l3_freeze_log(void);
+void test_l3_crash_log(void);
+void test_l3_crash_thread_log(void);
+void *test_l3_crash_thread(void *arg);
+int test_l3_crash_overflow(volatile char *prev);
+void test_l3_core_log(void);
+void test_l3_fork_log(void);
+void test_l3_fork_fail_log(void);
+void test_l3_shared_log(void);
+void *test_l3_shared_log_thread(void *arg);
+void test_l3_merge_log(void);
+void test_l3_merge_logs(const char *log, const char *child_log, int important);
+void test_l3_trace_log(void);
+void test_l3_span_log(void);
+void test_l3_str_log(void);
+void test_l3_bytes_log(void);
+void test_l3_enum_log(void);
+void test_l3_numa_log(void);
+void *test_l3_numa_log_thread(void *arg);
 
 int
 main(const int argc, const char **argv)
 {
     test_l3_fast_log();
     test_l3_slow_log();
+    test_l3_sampled_log();
+    test_l3_important_log();
+    test_l3_channel_log();
+    test_l3_freeze_log();
+    test_l3_crash_log();
+    test_l3_crash_thread_log();
+    test_l3_core_log();
+    test_l3_fork_log();
+    test_l3_fork_fail_log();
+    test_l3_shared_log();
+    test_l3_merge_log();
+    test_l3_trace_log();
+    test_l3_span_log();
+    test_l3_str_log();
+    test_l3_bytes_log();
+    test_l3_enum_log();
+    test_l3_numa_log();
 
     return 0;
 }
@@ -73,3 +128,636 @@ void test_l3_fast_log(void)
 
     printf("Generated fast log-entries to log-file: %s\n", log);
 }
+
+void test_l3_sampled_log(void)
+{
+    const char *log = "/tmp/l3.c-sample-unit-test.dat";
+    int e = l3_init(log);
+    if (e) {
+        abort();
+    }
+    // Expect 10 log-entries: ictr = 0, 100, 200, ... 900
+    for (int ictr = 0; ictr < 1000; ictr++) {
+        l3_log_every_n(100, "Sampled-log-msg: 1-in-100, ictr=%d, arg2=%d", ictr, 0);
+    }
+
+    // Expect 13 log-entries: ictr = 0, 1, 2, then 3, 13, 23, ... 93
+    for (int ictr = 0; ictr < 100; ictr++) {
+        l3_log_first_k(3, 10, "Sampled-log-msg: first-3-then-1-in-10, ictr=%d, arg2=%d", ictr, 0);
+    }
+
+    // Expect 5 log-entries, as the loop runs well within the 1st second.
+    for (int ictr = 0; ictr < 1000; ictr++) {
+        l3_log_max_rate(5, "Sampled-log-msg: max-5/sec, ictr=%d, arg2=%d", ictr, 0);
+    }
+
+    printf("Generated sampled log-entries to log-file: %s\n", log);
+}
+
+void test_l3_important_log(void)
+{
+    const char *log = "/tmp/l3.c-important-unit-test.dat";
+    int e = l3_init(log);
+    if (e) {
+        abort();
+    }
+    l3_log_lvl(L3_LVL_ERROR, "Important-log-msg: error, ictr=%d, arg2=%d", 0, 1);
+
+    // Flood the default ring-buffer, so that it wraps around. The error
+    // entry above survives in the ring of important entries.
+    for (int ictr = 0; ictr < (L3_MAX_SLOTS + 100); ictr++) {
+        if (ictr == (L3_MAX_SLOTS + 50)) {
+            l3_log_lvl(L3_LVL_WARN, "Important-log-msg: warning, ictr=%d, arg2=%d", ictr, 1);
+        }
+        l3_log_lvl(L3_LVL_DEBUG, "Debug-log-msg: flood, ictr=%d, arg2=%d", ictr, 0);
+    }
+
+    printf("Generated important log-entries to log-file: %s\n", log);
+}
+
+void test_l3_channel_log(void)
+{
+    const char *log = "/tmp/l3.c-channel-unit-test.dat";
+    int e = l3_init(log);
+    if (e) {
+        abort();
+    }
+    // # of slots is rounded up to 128. Re-opening returns the same channel.
+    l3_channel_t net = l3_channel_open("net", 100);
+    l3_channel_t storage = l3_channel_open("storage", 16);
+    if (!net || !storage || (l3_channel_open("net", 8) != net)) {
+        abort();
+    }
+
+    // Channel "net" wraps around, retaining the last 128 of 200 entries.
+    for (int ictr = 0; ictr < 200; ictr++) {
+        l3_log_ch(net, "Channel-log-msg: net, ictr=%d, arg2=%d", ictr, 0);
+        if ((ictr % 20) == 0) {
+            l3_log("Channel-log-msg: default, ictr=%d, arg2=%d", ictr, 1);
+        }
+        if ((ictr % 40) == 0) {
+            l3_log_ch(storage, "Channel-log-msg: storage, ictr=%d, arg2=%d", ictr, 2);
+        }
+    }
+
+    printf("Generated channel log-entries to log-file: %s\n", log);
+}
+
+void test_l3_freeze_log(void)
+{
+    const char *log = "/tmp/l3.c-freeze-unit-test.dat";
+    int e = l3_init(log);
+    if (e) {
+        abort();
+    }
+    // Expect entries ictr = 0 .. 59 to be retained, with the important
+    // entry at ictr = 55. Entries logged once frozen are not retained.
+    for (int ictr = 0; ictr < 100; ictr++) {
+        if (ictr % 2) {
+            l3_log_fast("Freeze-log-msg: fast, ictr=%d, arg2=%d", ictr, 0);
+        } else {
+            l3_log("Freeze-log-msg: slow, ictr=%d, arg2=%d", ictr, 0);
+        }
+        if (ictr == 50) {
+            if (l3_freeze_after(9)) {
+                abort();
+            }
+        }
+        if ((ictr == 55) || (ictr == 70)) {
+            l3_log_important("Freeze-log-msg: important, ictr=%d, arg2=%d", ictr, 1);
+        }
+    }
+
+    // Expect entries logged after the thaw to follow the frozen window.
+    if (l3_thaw()) {
+        abort();
+    }
+    for (int ictr = 100; ictr < 103; ictr++) {
+        l3_log("Freeze-log-msg: slow, ictr=%d, arg2=%d", ictr, 0);
+        if (ictr == 101) {
+            l3_log_important("Freeze-log-msg: important, ictr=%d, arg2=%d", ictr, 1);
+        }
+    }
+
+    printf("Generated frozen log-entries to log-file: %s\n", log);
+}
+
+void test_l3_crash_log(void)
+{
+    const char *log = "/tmp/l3.c-crash-unit-test.dat";
+
+    // Crash a child process, logging to an in-memory ring.
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (l3_init(NULL) || l3_init_crash_dump(log)) {
+            _exit(1);
+        }
+        l3_channel_t net = l3_channel_open("net", 16);
+        if (!net) {
+            _exit(1);
+        }
+        for (int ictr = 0; ictr < 10; ictr++) {
+            l3_log("Crash-log-msg: slow, ictr=%d, arg2=%d", ictr, 0);
+            l3_log_ch(net, "Crash-log-msg: net, ictr=%d, arg2=%d", ictr, 1);
+        }
+        abort();
+    }
+
+    int status = 0;
+    if ((pid == -1) || (waitpid(pid, &status, 0) != pid)
+        || !WIFSIGNALED(status) || (WTERMSIG(status) != SIGABRT)) {
+        abort();
+    }
+    printf("Generated crash-dump of log-entries to log-file: %s\n", log);
+}
+
+void test_l3_crash_thread_log(void)
+{
+    const char *log = "/tmp/l3.c-crash-thread-unit-test.dat";
+
+    // Crash a child process by a stack overflow in a thread other than the
+    // one that called l3_init_crash_dump().
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (l3_init(NULL) || l3_init_crash_dump(log)) {
+            _exit(1);
+        }
+        pthread_attr_t attr;
+        pthread_t thread;
+        if (   pthread_attr_init(&attr)
+            || pthread_attr_setstacksize(&attr, (256 * 1024))
+            || pthread_create(&thread, &attr, test_l3_crash_thread, NULL)) {
+            _exit(1);
+        }
+        pthread_join(thread, NULL);
+        _exit(1);
+    }
+
+    int status = 0;
+    if ((pid == -1) || (waitpid(pid, &status, 0) != pid)
+        || !WIFSIGNALED(status) || (WTERMSIG(status) != SIGSEGV)) {
+        abort();
+    }
+    printf("Generated crash-dump of log-entries to log-file: %s\n", log);
+}
+
+void *test_l3_crash_thread(void *arg)
+{
+    for (int ictr = 0; ictr < 3; ictr++) {
+        l3_log("Crash-thread-log-msg: ictr=%d, arg2=%d", ictr, 2);
+    }
+    volatile char buf[1] = { 0 };
+    test_l3_crash_overflow(buf);
+    return arg;
+}
+
+int test_l3_crash_overflow(volatile char *prev)
+{
+    volatile char buf[1024];
+    if (!prev) {
+        return 0;
+    }
+    buf[0] = (prev[0] + 1);
+    return (test_l3_crash_overflow(buf) + buf[0]);
+}
+
+void test_l3_core_log(void)
+{
+    const char *dir = "/tmp/l3.c-core-unit-test";
+    mkdir(dir, 0777);
+
+    // Crash a child process, logging to an in-memory ring, to dump core
+    // in 'dir'. Core dumps may be disabled, e.g. piped, by the system.
+    pid_t pid = fork();
+    if (pid == 0) {
+        struct rlimit rlim = { RLIM_INFINITY, RLIM_INFINITY };
+        if (chdir(dir) || setrlimit(RLIMIT_CORE, &rlim)) {
+            _exit(1);
+        }
+        unlink("core");
+        if (l3_init(NULL)) {
+            _exit(1);
+        }
+        l3_channel_t net = l3_channel_open("net", 16);
+        if (!net) {
+            _exit(1);
+        }
+        for (int ictr = 0; ictr < 10; ictr++) {
+            l3_log("Core-log-msg: slow, ictr=%d, arg2=%d", ictr, 0);
+            l3_log_ch(net, "Core-log-msg: net, ictr=%d, arg2=%d", ictr, 1);
+        }
+        abort();
+    }
+
+    int status = 0;
+    if ((pid == -1) || (waitpid(pid, &status, 0) != pid)
+        || !WIFSIGNALED(status) || (WTERMSIG(status) != SIGABRT)) {
+        abort();
+    }
+    printf("Generated log-entries to core-file, %s, in: %s\n",
+           (WCOREDUMP(status) ? "dumped" : "not dumped"), dir);
+}
+
+void test_l3_fork_log(void)
+{
+    const char *log = "/tmp/l3.c-fork-unit-test.dat";
+    int e = l3_init(log);
+    if (e) {
+        abort();
+    }
+    l3_channel_t net = l3_channel_open("net", 16);
+    if (!net) {
+        abort();
+    }
+    l3_log("Fork-log-msg: parent, ictr=%d, arg2=%d", 0, 0);
+
+    // Expect the child to log to its own ring, in <log>.<child's pid>
+    pid_t pid = fork();
+    if (pid == 0) {
+        for (int ictr = 0; ictr < 3; ictr++) {
+            l3_log("Fork-log-msg: child, ictr=%d, arg2=%d", ictr, 1);
+            l3_log_ch(net, "Fork-log-msg: child net, ictr=%d, arg2=%d", ictr, 2);
+        }
+        _exit(0);
+    }
+
+    int status = 0;
+    if ((pid == -1) || (waitpid(pid, &status, 0) != pid)
+        || !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+        abort();
+    }
+    l3_log("Fork-log-msg: parent, forked child pid=%d, arg2=%d", pid, 0);
+
+    printf("Generated log-entries to log-file: %s, and %s.%d for child\n",
+           log, log, pid);
+}
+
+void test_l3_fork_fail_log(void)
+{
+    const char *log = "/tmp/l3.c-fork-fail-unit-test.dat";
+    int e = l3_init(log);
+    if (e) {
+        abort();
+    }
+    l3_channel_t net = l3_channel_open("net", 16);
+    if (!net) {
+        abort();
+    }
+    l3_log("Fork-fail-log-msg: parent, ictr=%d, arg2=%d", 0, 0);
+    l3_log_ch(net, "Fork-fail-log-msg: parent net, ictr=%d, arg2=%d", 0, 2);
+    l3_log("Fork-fail-log-msg: parent, ictr=%d, arg2=%d", 1, 0);
+
+    // Fail the child's ftruncate() of its log-file: Expect the child to
+    // neither rewind the parent's rings, nor log to them.
+    struct rlimit fsize;
+    if (getrlimit(RLIMIT_FSIZE, &fsize)) {
+        abort();
+    }
+    struct rlimit small = { .rlim_cur = 1, .rlim_max = fsize.rlim_max };
+    void (*sigxfsz)(int) = signal(SIGXFSZ, SIG_IGN);
+    if (setrlimit(RLIMIT_FSIZE, &small)) {
+        abort();
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        for (int ictr = 0; ictr < 3; ictr++) {
+            l3_log("Fork-fail-log-msg: child, ictr=%d, arg2=%d", ictr, 1);
+            l3_log_ch(net, "Fork-fail-log-msg: child net, ictr=%d, arg2=%d", ictr, 3);
+        }
+        l3_log_important("Fork-fail-log-msg: child important, ictr=%d, arg2=%d", 3, 3);
+        _exit(0);
+    }
+    if (setrlimit(RLIMIT_FSIZE, &fsize) || (signal(SIGXFSZ, sigxfsz) == SIG_ERR)) {
+        abort();
+    }
+
+    int status = 0;
+    if ((pid == -1) || (waitpid(pid, &status, 0) != pid)
+        || !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+        abort();
+    }
+    l3_log("Fork-fail-log-msg: parent, forked child pid=%d, arg2=%d", pid, 0);
+    l3_log_ch(net, "Fork-fail-log-msg: parent net, ictr=%d, arg2=%d", 1, 2);
+
+    printf("Generated log-entries to log-file: %s, with no log-file for child\n",
+           log);
+}
+
+void test_l3_shared_log(void)
+{
+    const char *log = "/tmp/l3.c-shared-unit-test.dat";
+
+    // Start afresh, so that this process creates the shared log-file.
+    unlink(log);
+    int e = l3_init_shared(log);
+    if (e) {
+        abort();
+    }
+    l3_log("Shared-log-msg: parent, ictr=%d, arg2=%d", 0, 0);
+
+    // Expect the child to log to the same ring, tagged with its own pid.
+    pid_t pid = fork();
+    if (pid == 0) {
+        for (int ictr = 0; ictr < 3; ictr++) {
+            l3_log("Shared-log-msg: child, ictr=%d, arg2=%d", ictr, 1);
+        }
+        // Re-attach, as an unrelated process would, to the existing log-file.
+        if (l3_init_shared(log)) {
+            _exit(1);
+        }
+        l3_log("Shared-log-msg: child attached, ictr=%d, arg2=%d", 3, 1);
+
+        // Expect threads of an attached process to be tagged with its pid.
+        pthread_t thread;
+        if (   pthread_create(&thread, NULL, test_l3_shared_log_thread, NULL)
+            || pthread_join(thread, NULL)) {
+            _exit(1);
+        }
+        _exit(0);
+    }
+
+    int status = 0;
+    if ((pid == -1) || (waitpid(pid, &status, 0) != pid)
+        || !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+        abort();
+    }
+    l3_log("Shared-log-msg: parent, forked child pid=%d, arg2=%d", pid, 0);
+
+    printf("Generated log-entries to shared log-file: %s\n", log);
+}
+
+void *test_l3_shared_log_thread(void *arg)
+{
+    l3_log("Shared-log-msg: child thread, ictr=%d, arg2=%d", 4, 1);
+    l3_log_fast("Shared-log-msg: child thread, ictr=%d, arg2=%d", 5, 1);
+    return arg;
+}
+
+void test_l3_merge_log(void)
+{
+    test_l3_merge_logs("/tmp/l3.c-merge-unit-test.dat",
+                       "/tmp/l3.c-merge-child-unit-test.dat", 1);
+
+    // Entries of the default ring carry timestamps only under L3_MSGID_ENABLED.
+    test_l3_merge_logs("/tmp/l3.c-merge-default-unit-test.dat",
+                       "/tmp/l3.c-merge-default-child-unit-test.dat", 0);
+}
+
+void test_l3_merge_logs(const char *log, const char *child_log, int important)
+{
+    int to_child[2];
+    int to_parent[2];
+    if (pipe(to_child) || pipe(to_parent)) {
+        abort();
+    }
+
+    // Parent and child log to their own log-files, taking turns, so that
+    // merging both log-files by time yields ictr = 0, 1, 2, ... 7.
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (l3_init(child_log)) {
+            _exit(1);
+        }
+        char token;
+        for (int ictr = 1; ictr < 8; ictr += 2) {
+            if (read(to_child[0], &token, 1) != 1) {
+                _exit(1);
+            }
+            if (important) {
+                l3_log_important("Merge-log-msg: child, ictr=%d, arg2=%d", ictr, 1);
+            } else {
+                l3_log("Merge-log-msg: child, ictr=%d, arg2=%d", ictr, 1);
+            }
+            if (write(to_parent[1], &token, 1) != 1) {
+                _exit(1);
+            }
+        }
+        _exit(0);
+    }
+    if ((pid == -1) || l3_init(log)) {
+        abort();
+    }
+
+    char token = 0;
+    for (int ictr = 0; ictr < 8; ictr += 2) {
+        if (important) {
+            l3_log_important("Merge-log-msg: parent, ictr=%d, arg2=%d", ictr, 0);
+        } else {
+            l3_log("Merge-log-msg: parent, ictr=%d, arg2=%d", ictr, 0);
+        }
+        if ((write(to_child[1], &token, 1) != 1)
+            || (read(to_parent[0], &token, 1) != 1)) {
+            abort();
+        }
+    }
+
+    int status = 0;
+    if ((waitpid(pid, &status, 0) != pid)
+        || !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+        abort();
+    }
+    close(to_child[0]);
+    close(to_child[1]);
+    close(to_parent[0]);
+    close(to_parent[1]);
+
+    printf("Generated log-entries to log-files: %s, and %s for child\n",
+           log, child_log);
+}
+
+void test_l3_trace_log(void)
+{
+    const char *log = "/tmp/l3.c-trace-unit-test.dat";
+    int e = l3_init(log);
+    if (e) {
+        abort();
+    }
+    // Expect 3 slices, each with 1 instant event nested in it.
+    for (int ictr = 0; ictr < 3; ictr++) {
+        l3_log("Begin trace-request id=%d, arg2=%d", ictr, 0);
+        l3_log("Trace-log-msg: processing, ictr=%d, arg2=%d", ictr, 1);
+        l3_log("End trace-request id=%d, arg2=%d", ictr, 0);
+    }
+
+    printf("Generated log-entries to log-file: %s\n", log);
+}
+
+void test_l3_span_log(void)
+{
+    const char *log = "/tmp/l3.c-span-unit-test.dat";
+    int e = l3_init(log);
+    if (e) {
+        abort();
+    }
+    // Expect 1 'outer' span, around 100 'inner' spans.
+    l3_span_t outer = l3_span_begin("outer");
+    for (int ictr = 0; ictr < 100; ictr++) {
+        l3_span_t inner = l3_span_begin("inner");
+        l3_log("Span-log-msg: ictr=%d, arg2=%d", ictr, 0);
+        l3_span_end("inner", inner);
+    }
+    l3_span_end("outer", outer);
+
+    // Expect this span to be reported as not ended.
+    l3_span_t unended = l3_span_begin("unended");
+    (void) unended;
+
+    printf("Generated span log-entries to log-file: %s\n", log);
+}
+
+void test_l3_str_log(void)
+{
+    const char *log = "/tmp/l3.c-str-unit-test.dat";
+    int e = l3_init(log);
+    if (e) {
+        abort();
+    }
+    // Expect strings to fit in the entry, in 1 or 2 continuation entries,
+    // and to be truncated to L3_LOG_STR_MAX bytes.
+    const char *names[] = { "", "abc", "12345678",
+                            "queue-0123456789abcdef",
+                            "client-0123456789abcdefghijklmnopqrstuvwxyz",
+                            "file-0123456789abcdefghijklmnopqrstuvwxyz"
+                                "ABCDEFGHIJKLMNOPQRSTUVWXYZ" };
+    for (int ictr = 0; ictr < (int) (sizeof(names) / sizeof(*names)); ictr++) {
+        l3_log_str("Str-log-msg: name='%s'", names[ictr], strlen(names[ictr]));
+        l3_log("Str-log-msg: ictr=%d, arg2=%d", ictr, 0);
+    }
+
+    // Not a literal string.
+    char name[32];
+    snprintf(name, sizeof(name), "pid-%d", (int) getpid());
+    l3_log_str("Str-log-msg: dynamic name='%s'", name, strlen(name));
+
+    printf("Generated string log-entries to log-file: %s\n", log);
+}
+
+void test_l3_bytes_log(void)
+{
+    const char *log = "/tmp/l3.c-bytes-unit-test.dat";
+    int e = l3_init(log);
+    if (e) {
+        abort();
+    }
+    // Laid out as requestMsg{} of the client-server programs, so that its
+    // decoder, svmsg_decoders.py, decodes it.
+    struct {
+        long    mtype;
+        int     clientId;
+        int     client_idx;
+        int64_t counter;
+    } req = { 2, 42, 7, 1000 };
+    l3_log_bytes("Bytes-log-msg: req: %s", "requestMsg", &req, sizeof(req));
+
+    // Expect buffers without a decoder to be hexdumped, and to be truncated
+    // to L3_LOG_BYTES_MAX bytes.
+    unsigned char buf[200];
+    for (int ictr = 0; ictr < (int) sizeof(buf); ictr++) {
+        buf[ictr] = (unsigned char) ictr;
+    }
+    l3_log_bytes("Bytes-log-msg: buf: %s", "buffer", buf, 3);
+    l3_log_bytes("Bytes-log-msg: buf: %s", "buffer", buf, sizeof(buf));
+    l3_log("Bytes-log-msg: ictr=%d, arg2=%d", 1, 2);
+
+    printf("Generated bytes log-entries to log-file: %s\n", log);
+}
+
+void test_l3_enum_log(void)
+{
+    const char *log = "/tmp/l3.c-enum-unit-test.dat";
+    int e = l3_init(log);
+    if (e) {
+        abort();
+    }
+    test_l3_state_t states[] = { TEST_L3_IDLE, TEST_L3_BUSY, TEST_L3_DONE,
+                                 TEST_L3_FAILED, (test_l3_state_t) 5 };
+    for (int ictr = 0; ictr < (int) (sizeof(states) / sizeof(*states)); ictr++) {
+        l3_log("Enum-log-msg: ictr=%d, state=%d{enum:test_l3_state_t}",
+               ictr, states[ictr]);
+    }
+    l3_log("Enum-log-msg: state=%d{enum:test_l3_state}, errno=%d{errno}",
+           TEST_L3_BUSY, ENOENT);
+
+    printf("Generated enum log-entries to log-file: %s\n", log);
+}
+
+void test_l3_numa_log(void)
+{
+    const char *log = "/tmp/l3.c-numa-unit-test.dat";
+
+    // Expect l3_init_numa() to fail if the log-file cannot grow beyond
+    // what l3_init() needs, to accommodate rings of the NUMA nodes.
+    struct stat st;
+    if (l3_init(log) || stat(log, &st) || l3_log_deinit(L3_LOG_MMAP)) {
+        abort();
+    }
+    struct rlimit fsize;
+    if (getrlimit(RLIMIT_FSIZE, &fsize)) {
+        abort();
+    }
+    struct rlimit small = { .rlim_cur = st.st_size, .rlim_max = fsize.rlim_max };
+    void (*sigxfsz)(int) = signal(SIGXFSZ, SIG_IGN);
+    if (setrlimit(RLIMIT_FSIZE, &small)) {
+        abort();
+    }
+    int e = l3_init_numa(log);
+    if ((e != -1) || (errno != EFBIG)
+        || setrlimit(RLIMIT_FSIZE, &fsize) || (signal(SIGXFSZ, sigxfsz) == SIG_ERR)) {
+        abort();
+    }
+
+    e = l3_init_numa(log);
+    if (e) {
+        abort();
+    }
+    // Expect entries of all threads, from the rings of their NUMA nodes,
+    // to be merged in the order logged, with the string, which is logged to
+    // the default ring, and the important entry.
+    for (int ictr = 0; ictr < 6; ictr++) {
+        if (ictr % 2) {
+            l3_log_fast("NUMA-log-msg: fast, ictr=%d, arg2=%d", ictr, 0);
+        } else {
+            l3_log("NUMA-log-msg: slow, ictr=%d, arg2=%d", ictr, 0);
+        }
+        if (ictr == 3) {
+            l3_log_str("NUMA-log-msg: str=%s", "default-ring", 12);
+        }
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, test_l3_numa_log_thread, NULL)
+        || pthread_join(thread, NULL)) {
+        abort();
+    }
+    l3_log_important("NUMA-log-msg: important, ictr=%d, arg2=%d", 8, 1);
+
+    // Rings of NUMA nodes do not take up named channels. "important" does.
+    for (int cctr = 1; cctr < L3_MAX_CHANNELS; cctr++) {
+        char name[16];
+        snprintf(name, sizeof(name), "ch%d", cctr);
+        if (!l3_channel_open(name, 16)) {
+            abort();
+        }
+    }
+    if (l3_channel_open("ch-too-many", 16) || (errno != ENOSPC)) {
+        abort();
+    }
+    l3_log("NUMA-log-msg: channels opened, ictr=%d, arg2=%d", 9, 0);
+    printf("Generated NUMA log-entries to log-file: %s\n", log);
+
+    // Expect logging to the default ring, once re-initialized.
+    log = "/tmp/l3.c-numa-off-unit-test.dat";
+    if (l3_init(log)) {
+        abort();
+    }
+    l3_log("NUMA-log-msg: slow, ictr=%d, arg2=%d", 10, 0);
+    l3_log_fast("NUMA-log-msg: fast, ictr=%d, arg2=%d", 11, 0);
+    printf("Generated log-entries to log-file: %s\n", log);
+}
+
+void *test_l3_numa_log_thread(void *arg)
+{
+    l3_log("NUMA-log-msg: thread, ictr=%d, arg2=%d", 6, 2);
+    l3_log_fast("NUMA-log-msg: thread, ictr=%d, arg2=%d", 7, 2);
+    return arg;
+}
@@ -0,0 +1,109 @@
+/**
+ * *****************************************************************************
+ * \file l3_stats-test.c
+ *
+ * Stand-alone unit-test to exercise the call-site hit counters, which the
+ * Makefile builds with -DL3_SITE_COUNTERS, and the l3_stats() report.
+ *
+ * \brief L3: Lightweight Logging Library - Call-site hit counters Unit-test
+ * \version 0.1
+ *
+ * \copyright Copyright (c) 2024
+ * *****************************************************************************
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "l3.h"
+
+#define NTHREADS    4
+#define NHOT_HITS   1000
+
+// Function prototypes
+void test_l3_site_hits(void);
+void *test_l3_site_hits_thread(void *arg);
+const char *test_l3_stats_line(const char *report, const char *msg);
+
+int
+main(const int argc, const char **argv)
+{
+    test_l3_site_hits();
+    return 0;
+}
+
+void test_l3_site_hits(void)
+{
+    const char *log = "/tmp/l3.c-stats-unit-test.dat";
+    int e = l3_init(log);
+    if (e) {
+        abort();
+    }
+
+    // Counters of threads that have exited are still reported.
+    pthread_t threads[NTHREADS];
+    for (int tctr = 0; tctr < NTHREADS; tctr++) {
+        if (pthread_create(&threads[tctr], NULL, test_l3_site_hits_thread, NULL)) {
+            abort();
+        }
+    }
+    for (int tctr = 0; tctr < NTHREADS; tctr++) {
+        pthread_join(threads[tctr], NULL);
+    }
+    l3_log("Stats-log-msg: cold, ictr=%d, arg2=%d", 0, 0);
+
+    // Expect hits to be counted, even as they flood the ring-buffer.
+    for (int ictr = 0; ictr < (L3_MAX_SLOTS + 1); ictr++) {
+        l3_log("Stats-log-msg: flood, ictr=%d, arg2=%d", ictr, 0);
+    }
+
+    char   *report = NULL;
+    size_t  report_len = 0;
+    FILE   *fh = open_memstream(&report, &report_len);
+    if (!fh || l3_stats(fh, 10)) {
+        abort();
+    }
+    fclose(fh);
+    printf("%s", report);
+
+    // Call-sites are listed, by their hits, after the summary line.
+    const char *flood = test_l3_stats_line(report, "Stats-log-msg: flood");
+    const char *hot = test_l3_stats_line(report, "Stats-log-msg: hot");
+    const char *cold = test_l3_stats_line(report, "Stats-log-msg: cold");
+    if (   (strtoull(flood, NULL, 10) != (L3_MAX_SLOTS + 1))
+        || (strtoull(hot, NULL, 10) != (NTHREADS * NHOT_HITS))
+        || (strtoull(cold, NULL, 10) != 1)
+        || !((flood < hot) && (hot < cold))
+        || !strstr(report, "l3_stats-test.c:")) {
+        abort();
+    }
+    free(report);
+
+    printf("Verified hits of call-sites, logged to log-file: %s\n", log);
+}
+
+void *test_l3_site_hits_thread(void *arg)
+{
+    for (int ictr = 0; ictr < NHOT_HITS; ictr++) {
+        l3_log("Stats-log-msg: hot, ictr=%d, arg2=%d", ictr, 1);
+    }
+    return arg;
+}
+
+/**
+ * Find the line of l3_stats()'s report for the call-site logging 'msg'.
+ * Aborts if there is none.
+ */
+const char *test_l3_stats_line(const char *report, const char *msg)
+{
+    const char *found = strstr(report, msg);
+    if (!found) {
+        abort();
+    }
+    while ((found > report) && (found[-1] != '\n')) {
+        found--;
+    }
+    return found;
+}
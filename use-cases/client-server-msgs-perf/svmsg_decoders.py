@@ -0,0 +1,44 @@
+# #############################################################################
+# svmsg_decoders.py: l3_dump.py decoders of the request / response messages
+# of the client-server programs, logged by l3_log_bytes(), e.g.:
+#
+#   ./l3_dump.py --log-file <server-log-file> --binary <server-binary> \
+#                --decoders use-cases/client-server-msgs-perf/svmsg_decoders.py
+# #############################################################################
+"""
+l3_dump.py decoders of the requestMsg{} and responseMsg{}, of svmsg_file.h.
+"""
+import struct
+
+# typedef struct requestMsg {
+#     req_resp_type_t mtype;
+#     int             clientId;
+#     int             client_idx;
+#     int64_t         counter;
+# } requestMsg;
+#
+# responseMsg{} has the same layout.
+SVMSG_LAYOUT = '<qiiq'
+
+# enum req_resp_type
+SVMSG_TYPES = { 0: 'REQ_MT_UNKNOWN',
+                1: 'REQ_MT_INIT',
+                2: 'REQ_MT_INCR',
+                3: 'REQ_MT_SET_THROUGHPUT',
+                4: 'REQ_MT_QUIT',
+                5: 'REQ_MT_EXIT',
+                6: 'RESP_MT_FAILURE',
+                7: 'RESP_MT_DATA',
+                8: 'RESP_MT_END' }
+
+# #############################################################################
+def svmsg_decode(blob:bytes) -> str:
+    """
+    Decode a requestMsg{}, or a responseMsg{}.
+    """
+    (mtype, client_id, client_idx, counter) = struct.unpack_from(SVMSG_LAYOUT, blob)
+    return (f"mtype={SVMSG_TYPES.get(mtype, mtype)}, clientId={client_id}, "
+            + f"client_idx={client_idx}, counter={counter}")
+
+L3_DECODERS = { 'requestMsg'  : svmsg_decode,
+                'responseMsg' : svmsg_decode }
@@ -517,6 +517,10 @@ svr_proc_process_msg(void *cfg)
             if (errno == EINTR) {       /* Interrupted by SIGCHLD handler? */
                 continue;               /* ... then restart msgrcv() */
             }
+#if L3_ENABLED
+            l3_log("Server msg: msgrcv() failed: serverId=%d, errno=%d{errno}",
+                   serverId, errno);
+#endif // L3_ENABLED
             errMsg("msgrcv");           /* Some other error */
             break;                      /* ... so terminate loop */
         }
@@ -583,6 +587,10 @@ svr_proc_process_msg(void *cfg)
 #if !defined(__cplusplus)
           case REQ_MT_QUIT:
           default:
+#if L3_ENABLED
+            l3_log("Server msg: Unexpected request: mtype=%d{enum:req_resp_type}"
+                   ", ClientID=%d", (int) req.mtype, req.clientId);
+#endif // L3_ENABLED
             assert(1 == 0);
             break;
 #endif  // __cplusplus
@@ -641,6 +649,14 @@ svr_op_ct_init(requestMsg *req)
     printf("Server: Client ID=%d joined. # active clients=%d (HWM=%d)\n",
            req->clientId, activeClients, (resp.client_idx + 1));
 
+#if L3_ENABLED
+    // Snapshot the messages; decoded by svmsg_decoders.py, for l3_dump.py.
+    l3_log_bytes("Server msg: Init request: %s", "requestMsg",
+                 req, sizeof(*req));
+    l3_log_bytes("Server msg: Init response: %s", "responseMsg",
+                 &resp, sizeof(resp));
+#endif // L3_ENABLED
+
     int rv = 0;
     if (msgsnd(req->clientId, &resp, RESP_MSG_SIZE, 0) == -1) {
         printf("Warning: msgsnd() to client ID=%d failed to deliver.\n",
@@ -0,0 +1,65 @@
+/**
+ * *****************************************************************************
+ * \file test-main.cpp
+ * \brief L3: Lightweight Logging Library C++20 typed front end Unit-test
+ * \version 0.1
+ *
+ * \copyright Copyright (c) 2024
+ *
+ * Exercise l3::log<"fmt {}">(args...), which checks its arguments against
+ * the format string at compile-time and logs their raw bits, so that
+ * l3_dump.py decodes doubles, negative integers, chars and pointers by
+ * their types. Also exercise l3_log_srcloc(), which identifies the call-site
+ * by its std::source_location.
+ *
+ * Usage: program-name
+ * *****************************************************************************
+ */
+#include <iostream>
+
+#include "l3.h"
+
+using namespace std;
+
+enum class Color : short { Red = -2, Green = 1 };
+
+// Function prototypes
+void log_src_locs(int niters);
+
+int
+main(const int argc, const char * argv[])
+{
+    const char *logfile = "/tmp/l3.typed-cpp20-test.dat";
+    int e = l3_init(logfile);
+    if (e) {
+        abort();
+    }
+    cout << "L3-logging C++20 typed front end unit-tests log file: "
+         << logfile << "\n";
+
+    double secs = 2.5;
+    int delta = -42;
+    l3::log<"Elapsed {} secs, delta={}">(secs, delta);
+
+    unsigned long nbytes = 18446744073709551615UL;
+    l3::log<"Read {} bytes, ratio={}">(nbytes, -0.125f);
+
+    l3::log<"Grade '{}', at addr={}">('A', (void *) 0xdeadbeef);
+
+    l3::log<"Color={}, valid={}">(Color::Red, true);
+
+    l3::log<"100% of {{braces}} are literal">();
+
+    log_src_locs(2);
+
+    return 0;
+}
+
+void
+log_src_locs(int niters)
+{
+    for (int ictr = 0; ictr < niters; ictr++) {
+        l3_log_srcloc("Source-location iteration {}", ictr);
+    }
+    l3_log_srcloc("Source-location done, ratio={}", 0.5);
+}